@@ -1,29 +1,76 @@
 #include "Book.h"
 
-Book::Book() : bookId(0), title(""), author(""), isbn(""), category(""), 
-               totalCopies(0), availableCopies(0), isAvailable(false) {}
+Book::Book() : bookId(0), title(""), author(), isbn(""), category(), 
+               totalCopies(0), availableCopies(0) {}
 
 Book::Book(int id, const std::string& title, const std::string& author, 
            const std::string& isbn, const std::string& category, int copies)
-    : bookId(id), title(title), author(author), isbn(isbn), category(category),
-      totalCopies(copies), availableCopies(copies) {
-    updateAvailability();
+    : bookId(id), title(title), author(StringPool::global().intern(author)), isbn(isbn),
+      category(StringPool::global().intern(category)),
+      totalCopies(copies), availableCopies(copies) {}
+
+std::optional<Book> Book::withCounts(int id, const std::string& title, const std::string& author,
+                                     const std::string& isbn, const std::string& category,
+                                     int totalCopies, int availableCopies) {
+    if (totalCopies < 0 || availableCopies < 0 || availableCopies > totalCopies) return std::nullopt;
+    std::optional<Book> book(std::in_place, id, title, author, isbn, category, totalCopies);
+    book->availableCopies.store(availableCopies, std::memory_order_relaxed);
+    return book;
+}
+
+Book::Book(const Book& other)
+    : bookId(other.bookId), title(other.title), author(other.author), isbn(other.isbn),
+      category(other.category), totalCopies(other.totalCopies),
+      availableCopies(other.getAvailableCopies()) {}
+
+Book::Book(Book&& other) noexcept
+    : bookId(other.bookId), title(std::move(other.title)), author(other.author), isbn(std::move(other.isbn)),
+      category(other.category), totalCopies(other.totalCopies),
+      availableCopies(other.getAvailableCopies()) {}
+
+Book& Book::operator=(const Book& other) {
+    if (this != &other) {
+        bookId = other.bookId;
+        title = other.title;
+        author = other.author;
+        isbn = other.isbn;
+        category = other.category;
+        totalCopies = other.totalCopies;
+        availableCopies.store(other.getAvailableCopies(), std::memory_order_release);
+    }
+    return *this;
+}
+
+Book& Book::operator=(Book&& other) noexcept {
+    bookId = other.bookId;
+    title = std::move(other.title);
+    author = other.author;
+    isbn = std::move(other.isbn);
+    category = other.category;
+    totalCopies = other.totalCopies;
+    availableCopies.store(other.getAvailableCopies(), std::memory_order_release);
+    return *this;
 }
 
 bool Book::borrowBook() {
-    if (availableCopies > 0) {
-        availableCopies--;
-        updateAvailability();
-        return true;
+    int current = availableCopies.load(std::memory_order_relaxed);
+    while (current > 0) {
+        // 失败时 current 被更新为最新值，重新判断
+        if (availableCopies.compare_exchange_weak(current, current - 1,
+                                                  std::memory_order_acq_rel, std::memory_order_relaxed)) {
+            return true;
+        }
     }
     return false;
 }
 
 bool Book::returnBook() {
-    if (availableCopies < totalCopies) {
-        availableCopies++;
-        updateAvailability();
-        return true;
+    int current = availableCopies.load(std::memory_order_relaxed);
+    while (current < totalCopies) {
+        if (availableCopies.compare_exchange_weak(current, current + 1,
+                                                  std::memory_order_acq_rel, std::memory_order_relaxed)) {
+            return true;
+        }
     }
     return false;
 }
@@ -31,19 +78,16 @@ bool Book::returnBook() {
 void Book::displayBookInfo() const {
     std::cout << "图书ID: " << bookId << std::endl;
     std::cout << "书名: " << title << std::endl;
-    std::cout << "作者: " << author << std::endl;
+    std::cout << "作者: " << author.str() << std::endl;
     std::cout << "ISBN: " << isbn << std::endl;
-    std::cout << "分类: " << category << std::endl;
+    std::cout << "分类: " << category.str() << std::endl;
     std::cout << "总数量: " << totalCopies << std::endl;
-    std::cout << "可借数量: " << availableCopies << std::endl;
-    std::cout << "状态: " << (isAvailable ? "可借" : "不可借") << std::endl;
+    const int available = getAvailableCopies();
+    std::cout << "可借数量: " << available << std::endl;
+    std::cout << "状态: " << (available > 0 ? "可借" : "不可借") << std::endl;
 }
 
 void Book::displayDetailedInfo() const {
     displayBookInfo();
     std::cout << "详细信息已显示" << std::endl;
 }
-
-void Book::updateAvailability() {
-    isAvailable = (availableCopies > 0);
-}
\ No newline at end of file
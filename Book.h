@@ -1,43 +1,56 @@
 #ifndef BOOK_FINAL_H
 #define BOOK_FINAL_H
 
+#include <atomic>
+#include <optional>
 #include <string>
 #include <iostream>
+#include "StringPool.h"
 
 class Book {
 private:
     int bookId;
     std::string title;
-    std::string author;
+    Symbol author;      // 驻留在 StringPool::global()，同名作者共享一份字符串
     std::string isbn;
-    std::string category;
+    Symbol category;    // 同上，分类比较只需比较指针
     int totalCopies;
-    int availableCopies;
-    bool isAvailable;
+    // 可借副本数：借还用 CAS 增减，多个线程可同时借还同一本书而无需加锁；
+    // 是否可借由它直接得出，不再单独保存
+    std::atomic<int> availableCopies;
 
 public:
     Book();
     Book(int id, const std::string& title, const std::string& author, 
          const std::string& isbn, const std::string& category, int copies);
+    // 按总数与可借数直接构造（载入已有数据时使用）；
+    // 数量为负或可借数超过总数时返回空
+    static std::optional<Book> withCounts(int id, const std::string& title, const std::string& author,
+                                          const std::string& isbn, const std::string& category,
+                                          int totalCopies, int availableCopies);
+    // std::atomic 不可复制，复制/移动时取可借数的当前值
+    Book(const Book& other);
+    Book(Book&& other) noexcept;
+    Book& operator=(const Book& other);
+    Book& operator=(Book&& other) noexcept;
     
     // 基本访问方法
     int getBookId() const { return bookId; }
-    std::string getTitle() const { return title; }
-    std::string getAuthor() const { return author; }
-    std::string getIsbn() const { return isbn; }
-    std::string getCategory() const { return category; }
+    const std::string& getTitle() const { return title; }
+    const std::string& getAuthor() const { return author.str(); }
+    const std::string& getIsbn() const { return isbn; }
+    const std::string& getCategory() const { return category.str(); }
+    Symbol getAuthorSymbol() const { return author; }
+    Symbol getCategorySymbol() const { return category; }
     int getTotalCopies() const { return totalCopies; }
-    int getAvailableCopies() const { return availableCopies; }
-    bool getIsAvailable() const { return isAvailable; }
+    int getAvailableCopies() const { return availableCopies.load(std::memory_order_acquire); }
+    bool getIsAvailable() const { return getAvailableCopies() > 0; }
     
-    // 业务方法
+    // 业务方法（线程安全）：无副本可借/已全部归还时返回 false
     bool borrowBook();
     bool returnBook();
     void displayBookInfo() const;
     void displayDetailedInfo() const;
-    
-protected:
-    void updateAvailability();
 };
 
 #endif
@@ -0,0 +1,325 @@
+#include "BookImporter.h"
+#include "BoundedQueue.h"
+#include "TsvFormat.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <optional>
+#include <string_view>
+#include <thread>
+#include <utility>
+
+namespace {
+
+constexpr std::size_t kReadChunkBytes = 1 << 20;
+constexpr std::size_t kMaxBatchBytes = 4 << 20; // 每批记录文本的字节数上限（另加至多一条记录）
+constexpr std::size_t kMinFields = 6;  // ID 书名 作者 ISBN 分类 总数
+constexpr std::size_t kMaxFields = 7;  // 可选的可借数
+
+// 读取阶段的输出：一批记录连续存放在 text 中
+struct RecordBatch {
+    std::string text;
+    std::vector<std::pair<std::size_t, std::size_t>> spans; // 每条记录在 text 中的起点与长度
+    std::vector<std::size_t> lines;                          // 每条记录的起始行号
+    std::uint64_t bytesRead = 0;                             // 读到此批末尾为止的字节数
+    std::vector<std::string> errors;                         // 读取阶段丢弃的超长记录
+    std::size_t rejected = 0;
+};
+
+// 校验阶段的输出
+struct BookBatch {
+    std::vector<Book> books;
+    std::vector<std::string> errors;
+    std::size_t records = 0;
+    std::size_t rejected = 0;
+    std::uint64_t bytesRead = 0;
+};
+
+std::string_view trim(std::string_view s) {
+    while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) s.remove_prefix(1);
+    while (!s.empty() && (s.back() == ' ' || s.back() == '\t')) s.remove_suffix(1);
+    return s;
+}
+
+// 切分一条 CSV 记录：去掉包围字段的双引号，"" 还原为一个引号。返回字段数（至多 maxFields）
+std::size_t splitCsv(std::string_view record, std::string* fields, std::size_t maxFields) {
+    std::size_t count = 0;
+    std::size_t i = 0;
+    while (count < maxFields) {
+        std::string& field = fields[count++];
+        field.clear();
+        if (i < record.size() && record[i] == '"') {
+            for (++i; i < record.size(); ++i) {
+                if (record[i] != '"') field += record[i];
+                else if (i + 1 < record.size() && record[i + 1] == '"') field += record[++i];
+                else break;
+            }
+            ++i; // 结束引号
+            std::size_t comma = record.find(',', i);
+            if (comma == std::string_view::npos) break;
+            i = comma + 1;
+        } else {
+            std::size_t comma = record.find(',', i);
+            field.assign(record.substr(i, comma == std::string_view::npos ? std::string_view::npos : comma - i));
+            if (comma == std::string_view::npos) break;
+            i = comma + 1;
+        }
+    }
+    return count;
+}
+
+std::size_t splitTsv(std::string_view record, std::string* fields, std::size_t maxFields) {
+    std::string_view parts[kMaxFields];
+    std::size_t count = tsv::split(record, parts, maxFields);
+    for (std::size_t i = 0; i < count; ++i) fields[i] = tsv::unescape(parts[i]);
+    return count;
+}
+
+// 解析一条记录；失败时返回空并给出原因
+std::optional<Book> parseRecord(const std::string* fields, std::size_t count, const char*& error) {
+    int id = 0, total = 0;
+    if (count < kMinFields) {
+        error = "字段不足";
+        return std::nullopt;
+    }
+    if (!tsv::parseInt(trim(fields[0]), id) || id <= 0) {
+        error = "ID 不是正整数";
+        return std::nullopt;
+    }
+    if (trim(fields[1]).empty()) {
+        error = "书名为空";
+        return std::nullopt;
+    }
+    if (!tsv::parseInt(trim(fields[5]), total)) {
+        error = "总数不是整数";
+        return std::nullopt;
+    }
+    int available = total;
+    if (count > kMinFields && !trim(fields[6]).empty() && !tsv::parseInt(trim(fields[6]), available)) {
+        error = "可借数不是整数";
+        return std::nullopt;
+    }
+    auto book = Book::withCounts(id, fields[1], fields[2], fields[3], fields[4], total, available);
+    if (!book) error = "副本数不合法";
+    return book;
+}
+
+// 读取阶段：按块读入，在记录边界（CSV 引号外的换行）切分，攒满一批后放入队列。
+// 记录超过 maxRecordBytes 时（多半是未闭合的引号）只丢弃它的首行，其后的内容按引号外重新切分；
+// 单行就超长时跳到下一个换行
+void readRecords(std::ifstream& in, bool csv, const BookImporter::Options& options,
+                 BoundedQueue<RecordBatch>& out, std::atomic<bool>& readFailed) {
+    const std::size_t batchSize = options.batchSize ? options.batchSize : 1;
+    const std::size_t maxRecordBytes =
+        std::min(options.maxRecordBytes, std::numeric_limits<std::size_t>::max() / 2); // 下面加一不溢出
+    std::string input;           // 待切分的数据：刚读入的一块，或需重新切分的内容加上块的剩余部分
+    std::size_t pos = 0;         // input 中下一个待切分的位置
+    RecordBatch batch;
+    std::size_t recordStart = 0; // 进行中的记录在 batch.text 中的起点
+    std::size_t line = 1;
+    std::size_t recordLine = 1;
+    std::uint64_t bytesRead = 0;
+    bool inQuotes = false;
+    bool skipping = false;       // 正在跳过超长单行的剩余部分
+
+    auto finishRecord = [&] {
+        std::size_t length = batch.text.size() - recordStart;
+        if (length > 0 && batch.text.back() == '\r') --length;
+        if (length == 0) {
+            batch.text.resize(recordStart);
+        } else {
+            batch.spans.emplace_back(recordStart, length);
+            batch.lines.push_back(recordLine);
+            recordStart = batch.text.size();
+        }
+    };
+    auto flush = [&] {
+        batch.bytesRead = bytesRead;
+        bool pushed = out.push(std::move(batch));
+        batch = RecordBatch();
+        recordStart = 0;
+        return pushed;
+    };
+
+    while (true) {
+        if (pos == input.size()) {
+            if (!in) break;
+            input.resize(kReadChunkBytes);
+            in.read(&input[0], static_cast<std::streamsize>(input.size()));
+            input.resize(static_cast<std::size_t>(in.gcount()));
+            pos = 0;
+            if (input.empty()) break;
+            bytesRead += input.size();
+        }
+        const char* const base = input.data();
+        const char* const end = base + input.size();
+        const char* p = base + pos;
+        if (skipping) {
+            p = static_cast<const char*>(std::memchr(p, '\n', static_cast<std::size_t>(end - p)));
+            if (!p) {
+                pos = input.size();
+                continue;
+            }
+            pos = static_cast<std::size_t>(p + 1 - base);
+            recordLine = ++line;
+            skipping = false;
+            continue;
+        }
+        // 本条记录至多再扫描到超出上限一个字节处
+        const char* start = p;
+        const std::size_t used = batch.text.size() - recordStart;
+        const char* limit = p + std::min(static_cast<std::size_t>(end - p), maxRecordBytes - used + 1);
+        if (csv) {
+            for (; p < limit; ++p) {
+                if (*p == '"') inQuotes = !inQuotes;
+                else if (*p == '\n') {
+                    if (!inQuotes) break;
+                    ++line; // 引号内的换行属于字段内容
+                }
+            }
+        } else {
+            p = static_cast<const char*>(std::memchr(p, '\n', static_cast<std::size_t>(limit - p)));
+            if (!p) p = limit;
+        }
+        if (p == limit && used + static_cast<std::size_t>(p - start) > maxRecordBytes) {
+            ++batch.rejected;
+            if (batch.errors.size() < options.maxErrors) {
+                batch.errors.push_back("第 " + std::to_string(recordLine) + " 行: 记录超过 " +
+                                       std::to_string(maxRecordBytes) + " 字节（可能有未闭合的引号），已跳过");
+            }
+            std::string record = batch.text.substr(recordStart);
+            record.append(start, p);
+            batch.text.resize(recordStart);
+            inQuotes = false;
+            const std::size_t newline = record.find('\n');
+            if (newline == std::string::npos) {
+                skipping = true;
+                pos = static_cast<std::size_t>(p - base);
+                continue;
+            }
+            // 从首行之后按引号外重新切分；每次回退至少前进一行
+            record.erase(0, newline + 1);
+            record.append(p, end);
+            input = std::move(record);
+            pos = 0;
+            recordLine = line = recordLine + 1;
+            continue;
+        }
+        batch.text.append(start, p);
+        if (p == end) { // 记录跨块，读下一块时继续
+            pos = input.size();
+            continue;
+        }
+        pos = static_cast<std::size_t>(p + 1 - base);
+        finishRecord();
+        recordLine = ++line;
+        if ((batch.spans.size() >= batchSize || batch.text.size() >= kMaxBatchBytes) && !flush()) return; // 已取消
+    }
+    if (in.bad()) readFailed = true;
+    finishRecord();
+    if (!batch.spans.empty() || batch.rejected > 0) flush();
+}
+
+} // namespace
+
+BookImporter::Result BookImporter::run(const std::string& filename, const Sink& sink,
+                                       const ProgressCallback& progress) const {
+    Result result;
+    std::ifstream in(filename, std::ios::binary);
+    if (!in) {
+        result.errors.push_back("无法打开 " + filename);
+        return result;
+    }
+    std::error_code ec;
+    result.progress.totalBytes = std::filesystem::file_size(filename, ec);
+
+    bool csv = options.format == Format::Csv;
+    if (options.format == Format::Auto) {
+        std::string extension = std::filesystem::path(filename).extension().string();
+        for (char& c : extension) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+        csv = extension == ".csv";
+    }
+    const std::size_t maxErrors = options.maxErrors;
+
+    BoundedQueue<RecordBatch> records(options.queueBatches);
+    BoundedQueue<BookBatch> books(options.queueBatches);
+    std::atomic<bool> readFailed{false};
+
+    std::thread reader([&] {
+        readRecords(in, csv, options, records, readFailed);
+        records.close();
+    });
+    std::thread validator([&] {
+        std::string fields[kMaxFields];
+        bool first = true;
+        while (auto batch = records.pop()) {
+            BookBatch parsed;
+            parsed.bytesRead = batch->bytesRead;
+            parsed.records = batch->rejected;
+            parsed.rejected = batch->rejected;
+            parsed.errors = std::move(batch->errors);
+            parsed.books.reserve(batch->spans.size());
+            for (std::size_t i = 0; i < batch->spans.size(); ++i) {
+                const std::string_view record(batch->text.data() + batch->spans[i].first, batch->spans[i].second);
+                const std::size_t count = csv ? splitCsv(record, fields, kMaxFields) : splitTsv(record, fields, kMaxFields);
+                int id = 0;
+                if (first && !tsv::parseInt(trim(fields[0]), id)) { // 表头
+                    first = false;
+                    continue;
+                }
+                first = false;
+                ++parsed.records;
+                const char* error = nullptr;
+                if (auto book = parseRecord(fields, count, error)) {
+                    parsed.books.push_back(std::move(*book));
+                } else {
+                    ++parsed.rejected;
+                    if (parsed.errors.size() < maxErrors) {
+                        parsed.errors.push_back("第 " + std::to_string(batch->lines[i]) + " 行: " + error);
+                    }
+                }
+            }
+            if (!books.push(std::move(parsed))) break;
+        }
+        books.close();
+    });
+
+    bool sinkFailed = false;
+    while (auto batch = books.pop()) {
+        Progress& current = result.progress;
+        current.bytesRead = batch->bytesRead;
+        current.records += batch->records;
+        current.rejected += batch->rejected;
+        for (auto& error : batch->errors) {
+            if (result.errors.size() < maxErrors) result.errors.push_back(std::move(error));
+        }
+        if (!batch->books.empty()) {
+            const std::size_t accepted = sink(batch->books);
+            if (accepted == kSinkFailed) {
+                sinkFailed = true;
+                result.errors.push_back("写入失败，导入中止");
+                break;
+            }
+            current.imported += accepted;
+            current.skipped += batch->books.size() - accepted;
+        }
+        if (progress && !progress(current)) {
+            result.cancelled = true;
+            break;
+        }
+    }
+    // 提前结束时关闭队列，阻塞在 push 上的阶段随之退出
+    records.close();
+    books.close();
+    reader.join();
+    validator.join();
+
+    if (readFailed) result.errors.push_back("读取 " + filename + " 失败");
+    result.ok = !sinkFailed && !result.cancelled && !readFailed;
+    return result;
+}
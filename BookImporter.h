@@ -0,0 +1,65 @@
+#ifndef BOOKIMPORTER_H
+#define BOOKIMPORTER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+#include "Book.h"
+
+// 批量导入图书（CSV 或 TSV）。三个阶段流水线执行：
+//   读取线程按块读文件并切分记录 -> 校验线程解析为 Book -> 调用线程把每批交给 sink 写入。
+// 阶段之间是有界队列，sink 跟不上时读取线程阻塞；单条记录与每批文本的字节数也有上限，
+// 因此即使 CSV 中有未闭合的引号，内存占用也与文件大小无关。
+//
+// 每行一条记录：ID、书名、作者、ISBN、分类、总数[、可借数]（省略可借数时等于总数）。
+// CSV 以逗号分隔，字段可用双引号包围（内含逗号、换行，"" 表示一个引号）；
+// TSV 与 books.tsv 相同，字段内的制表符、换行转义为反斜杠加 t / n。
+// 首条记录的 ID 不是数字时视为表头跳过。非法记录跳过并计数，不中断导入；
+// 超过 maxRecordBytes 的记录被丢弃，从下一个换行处重新开始切分。
+class BookImporter {
+public:
+    enum class Format { Auto, Csv, Tsv }; // Auto：扩展名为 .csv 时按 CSV，否则按 TSV
+
+    struct Options {
+        Format format = Format::Auto;
+        std::size_t batchSize = 4096;   // 每批交给 sink 的最大图书数
+        std::size_t queueBatches = 8;   // 每个队列最多缓存的批数
+        std::size_t maxErrors = 20;     // 最多保留的错误说明条数（计数不受限）
+        std::size_t maxRecordBytes = 1 << 20; // 单条记录的最大字节数
+    };
+
+    struct Progress {
+        std::uint64_t bytesRead = 0;
+        std::uint64_t totalBytes = 0;
+        std::size_t records = 0;        // 已校验的记录数（不含表头）
+        std::size_t imported = 0;       // sink 接受的图书数
+        std::size_t rejected = 0;       // 校验未通过的记录数
+        std::size_t skipped = 0;        // 通过校验但被 sink 拒绝的图书数（如 ID 重复）
+    };
+
+    struct Result {
+        bool ok = false;                // 文件可读且 sink 未报错；被取消时为 false
+        bool cancelled = false;
+        Progress progress;
+        std::vector<std::string> errors; // 如 "第 12 行: 书名为空"，至多 maxErrors 条
+    };
+
+    // 写入一批通过校验的图书，返回接受的数目；返回 kSinkFailed 表示写入失败，导入中止
+    using Sink = std::function<std::size_t(const std::vector<Book>& batch)>;
+    // 每批写入后在调用线程上报告进度；返回 false 时取消导入
+    using ProgressCallback = std::function<bool(const Progress& progress)>;
+
+    static constexpr std::size_t kSinkFailed = static_cast<std::size_t>(-1);
+
+    BookImporter() = default;
+    explicit BookImporter(Options options) : options(options) {}
+
+    Result run(const std::string& filename, const Sink& sink, const ProgressCallback& progress = nullptr) const;
+
+private:
+    Options options;
+};
+
+#endif // BOOKIMPORTER_H
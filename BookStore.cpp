@@ -0,0 +1,55 @@
+#include "BookStore.h"
+
+std::size_t BookStore::insert(const Book& book) {
+    std::size_t slot;
+    if (!freeSlots.empty()) {
+        slot = freeSlots.back();
+        freeSlots.pop_back();
+    } else {
+        slot = live.size();
+        if (slot / kChunkSize >= chunks.size()) {
+            chunks.push_back(std::make_unique<Chunk>());
+        }
+        live.push_back(0);
+        if (generations.size() < live.size()) generations.push_back(0);
+    }
+    at(slot) = book;
+    live[slot] = 1;
+    ++liveCount;
+    syncCounts(slot);
+    return slot;
+}
+
+void BookStore::erase(std::size_t slot) {
+    if (!isLive(slot)) return;
+    at(slot) = Book(); // 释放字符串占用的内存
+    live[slot] = 0;
+    syncCounts(slot);
+    ++generations[slot];
+    freeSlots.push_back(slot);
+    --liveCount;
+}
+
+void BookStore::syncCounts(std::size_t slot) {
+    Chunk& chunk = *chunks[slot / kChunkSize];
+    const std::size_t i = slot % kChunkSize;
+    const Book& book = chunk.books[i];
+    chunk.ids[i].store(book.getBookId(), std::memory_order_relaxed);
+    chunk.totalCopies[i].store(book.getTotalCopies(), std::memory_order_relaxed);
+    chunk.availableCopies[i].store(book.getAvailableCopies(), std::memory_order_relaxed);
+}
+
+void BookStore::clear() {
+    for (std::size_t slot = 0; slot < live.size(); ++slot) {
+        if (live[slot]) ++generations[slot];
+    }
+    chunks.clear();
+    live.clear();
+    freeSlots.clear();
+    liveCount = 0;
+}
+
+void BookStore::reserve(std::size_t count) {
+    live.reserve(count);
+    chunks.reserve((count + kChunkSize - 1) / kChunkSize);
+}
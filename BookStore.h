@@ -0,0 +1,153 @@
+#ifndef BOOKSTORE_H
+#define BOOKSTORE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <vector>
+#include "Book.h"
+
+// 指向 BookStore 槽位的句柄。槽位被删除（或复用）后代数会变化，
+// 旧句柄 resolve 时得到 nullptr，而不是悬空指针或另一本书。
+struct BookHandle {
+    std::uint32_t slot = UINT32_MAX;
+    std::uint32_t generation = 0;
+
+    bool isNull() const { return slot == UINT32_MAX; }
+    bool operator==(const BookHandle& other) const { return slot == other.slot && generation == other.generation; }
+    bool operator!=(const BookHandle& other) const { return !(*this == other); }
+};
+
+// 分块存储图书：每块固定容量，块一旦分配就不再移动，
+// 因此插入新书不会使已有的 Book* 失效。删除后的槽位进入空闲链表复用。
+class BookStore {
+public:
+    static constexpr std::size_t kChunkSize = 1024;
+
+    template <bool IsConst>
+    class Iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = Book;
+        using difference_type = std::ptrdiff_t;
+        using pointer = std::conditional_t<IsConst, const Book*, Book*>;
+        using reference = std::conditional_t<IsConst, const Book&, Book&>;
+        using StorePtr = std::conditional_t<IsConst, const BookStore*, BookStore*>;
+
+        Iterator() = default;
+        Iterator(StorePtr store, std::size_t slot) : store(store), slot(slot) { skipDead(); }
+
+        reference operator*() const { return store->at(slot); }
+        pointer operator->() const { return &store->at(slot); }
+        std::size_t slotIndex() const { return slot; }
+
+        Iterator& operator++() {
+            ++slot;
+            skipDead();
+            return *this;
+        }
+        Iterator operator++(int) {
+            Iterator copy = *this;
+            ++(*this);
+            return copy;
+        }
+        bool operator==(const Iterator& other) const { return slot == other.slot; }
+        bool operator!=(const Iterator& other) const { return slot != other.slot; }
+
+    private:
+        StorePtr store = nullptr;
+        std::size_t slot = 0;
+
+        void skipDead() {
+            while (store && slot < store->slotCount() && !store->isLive(slot)) ++slot;
+        }
+    };
+
+    using iterator = Iterator<false>;
+    using const_iterator = Iterator<true>;
+
+    // 一个块内的数值列（结构数组）。空槽位各列均为 0，
+    // 因此求和、按可借数筛选等聚合可以不检查 live 直接扫描。
+    // 借还只持有共享锁与分片锁即刷新可借数，读取方只持有共享锁，故各列为原子量，按 relaxed 读取
+    struct CountColumns {
+        const std::atomic<int>* ids;
+        const std::atomic<int>* totalCopies;
+        const std::atomic<int>* availableCopies;
+        std::size_t size;      // 本块已使用的槽位数
+        std::size_t firstSlot; // 本块第一个槽位的编号
+
+        int id(std::size_t i) const { return ids[i].load(std::memory_order_relaxed); }
+        int total(std::size_t i) const { return totalCopies[i].load(std::memory_order_relaxed); }
+        int available(std::size_t i) const { return availableCopies[i].load(std::memory_order_relaxed); }
+    };
+
+    BookStore() = default;
+    BookStore(const BookStore&) = delete;
+    BookStore& operator=(const BookStore&) = delete;
+
+    // 按槽位访问（调用方需保证槽位有效）
+    Book& at(std::size_t slot) { return chunks[slot / kChunkSize]->books[slot % kChunkSize]; }
+    const Book& at(std::size_t slot) const { return chunks[slot / kChunkSize]->books[slot % kChunkSize]; }
+    bool isLive(std::size_t slot) const { return slot < live.size() && live[slot] != 0; }
+
+    BookHandle handleAt(std::size_t slot) const {
+        return BookHandle{static_cast<std::uint32_t>(slot), generations[slot]};
+    }
+    Book* resolve(BookHandle handle) {
+        return isCurrent(handle) ? &at(handle.slot) : nullptr;
+    }
+    const Book* resolve(BookHandle handle) const {
+        return isCurrent(handle) ? &at(handle.slot) : nullptr;
+    }
+
+    std::size_t size() const { return liveCount; }
+    bool empty() const { return liveCount == 0; }
+    // 已使用过的槽位上界（包含空闲槽位）
+    std::size_t slotCount() const { return live.size(); }
+
+    std::size_t chunkCount() const { return chunks.size(); }
+    CountColumns columns(std::size_t chunk) const {
+        const Chunk& c = *chunks[chunk];
+        std::size_t first = chunk * kChunkSize;
+        std::size_t used = slotCount() - first;
+        return CountColumns{c.ids, c.totalCopies, c.availableCopies,
+                            used < kChunkSize ? used : kChunkSize, first};
+    }
+
+    iterator begin() { return iterator(this, 0); }
+    iterator end() { return iterator(this, slotCount()); }
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, slotCount()); }
+
+private:
+    friend class Library; // 只有 Library 能增删，保证其索引与存储同步
+
+    struct Chunk {
+        Book books[kChunkSize];
+        // 热数据列：books 中数值字段的镜像，由 insert/erase/syncCounts 维护
+        std::atomic<int> ids[kChunkSize] = {};
+        std::atomic<int> totalCopies[kChunkSize] = {};
+        std::atomic<int> availableCopies[kChunkSize] = {};
+    };
+
+    std::vector<std::unique_ptr<Chunk>> chunks;
+    std::vector<unsigned char> live;     // 槽位是否有效
+    std::vector<std::uint32_t> generations; // 槽位代数，删除时递增；clear 后保留以使旧句柄失效
+    std::vector<std::size_t> freeSlots;  // 可复用的空闲槽位
+    std::size_t liveCount = 0;
+
+    bool isCurrent(BookHandle handle) const {
+        return !handle.isNull() && isLive(handle.slot) && generations[handle.slot] == handle.generation;
+    }
+
+    std::size_t insert(const Book& book);
+    void erase(std::size_t slot);
+    void syncCounts(std::size_t slot); // Book 的副本数变化后刷新列镜像
+    void clear();
+    void reserve(std::size_t count);
+};
+
+#endif // BOOKSTORE_H
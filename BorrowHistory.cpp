@@ -0,0 +1,11 @@
+#include "BorrowHistory.h"
+
+void BorrowHistory::record(int bookId, BorrowAction action, std::time_t when) {
+    events[next] = BorrowEvent{static_cast<std::int64_t>(when), bookId, action};
+    next = (next + 1) % kCapacity;
+    if (count < kCapacity) ++count;
+}
+
+const BorrowEvent& BorrowHistory::recent(std::size_t index) const {
+    return events[(next + kCapacity - 1 - index) % kCapacity];
+}
@@ -0,0 +1,37 @@
+#ifndef BORROWHISTORY_H
+#define BORROWHISTORY_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+
+enum class BorrowAction : std::uint8_t { Borrow, Return };
+
+// 一条借还记录：只保存时间戳、图书ID和动作，显示时再格式化
+struct BorrowEvent {
+    std::int64_t timestamp = 0;
+    int bookId = 0;
+    BorrowAction action = BorrowAction::Borrow;
+};
+
+// 固定容量的环形缓冲区，写满后覆盖最旧的记录；记录时不分配内存
+class BorrowHistory {
+public:
+    static constexpr std::size_t kCapacity = 20;
+
+    void record(int bookId, BorrowAction action, std::time_t when = std::time(nullptr));
+    void clear() { next = 0; count = 0; }
+
+    std::size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    // index 0 为最近一条，越大越旧
+    const BorrowEvent& recent(std::size_t index) const;
+
+private:
+    std::array<BorrowEvent, kCapacity> events{};
+    std::size_t next = 0;  // 下一条写入的位置
+    std::size_t count = 0;
+};
+
+#endif // BORROWHISTORY_H
@@ -3,24 +3,27 @@
 
 #include <string>
 #include <vector>
-#include <deque>
 #include "Book.h"
+#include "BorrowHistory.h"
+#include "SmallIntSet.h"
 class Library;
 
+// 借阅人的具体类型：序列化时据此分派，不必比较类型名或 dynamic_cast
+enum class BorrowerKind { Student, Teacher };
+
 class Borrower {
 protected:
     std::string id;         // ID
     std::string name;       // 姓名
     std::string department; // 院系
     int maxBorrowLimit;     // 最大借阅数量
-    int currentBorrowCount; // 当前借阅数量
-    std::vector<int> borrowedBookIds; // 已借阅图书ID
-    std::deque<std::string> borrowHistory; // 历史记录
+    SmallIntSet borrowedBookIds; // 已借阅图书ID，当前借阅数量即其大小
+    BorrowHistory borrowHistory; // 最近的借还记录（定长环形缓冲）
 
 public:
-    Borrower() : id(""), name(""), department(""), maxBorrowLimit(0), currentBorrowCount(0) {}
+    Borrower() : id(""), name(""), department(""), maxBorrowLimit(0) {}
     Borrower(const std::string& id, const std::string& name, const std::string& dept, int limit)
-        : id(id), name(name), department(dept), maxBorrowLimit(limit), currentBorrowCount(0) {}
+        : id(id), name(name), department(dept), maxBorrowLimit(limit) {}
     
     virtual ~Borrower() {}
     
@@ -30,36 +33,39 @@ public:
     virtual void displayInfo() const;
     virtual void displayBorrowedBooks(Library& library) const;
     virtual void displayBorrowHistory() const;
+    // 同上，并从图书馆查出书名
+    virtual void displayBorrowHistory(const Library& library) const;
     
     // 强制派生类
     virtual std::string getType() const = 0;
+    virtual BorrowerKind getKind() const = 0;
     
     // 通用方法
-    bool canBorrowMore() const { return currentBorrowCount < maxBorrowLimit; }
-    bool hasBorrowedBook(int bookId) const;
-    void addToBorrowHistory(const std::string& record);
+    bool canBorrowMore() const { return getCurrentBorrowCount() < maxBorrowLimit; }
+    bool hasBorrowedBook(int bookId) const { return borrowedBookIds.contains(bookId); }
+    void addToBorrowHistory(int bookId, BorrowAction action) { borrowHistory.record(bookId, action); }
     
     // 获取器
-    std::string getId() const { return id; }
-    std::string getName() const { return name; }
-    std::string getDepartment() const { return department; }
+    const std::string& getId() const { return id; }
+    const std::string& getName() const { return name; }
+    const std::string& getDepartment() const { return department; }
     int getMaxBorrowLimit() const { return maxBorrowLimit; }
-    int getCurrentBorrowCount() const { return currentBorrowCount; }
+    int getCurrentBorrowCount() const { return static_cast<int>(borrowedBookIds.size()); }
+    const BorrowHistory& getBorrowHistory() const { return borrowHistory; }
     
 
-    void setId(const std::string& newId) { id = newId; }
+    void setId(const std::string& newId) { id = newId; } // 已加入 Library 的借阅人不要改 ID（索引按 ID 建立）
     void setName(const std::string& newName) { name = newName; }
     void setDepartment(const std::string& newDept) { department = newDept; }
     void setMaxBorrowLimit(int limit) { maxBorrowLimit = limit; }
     
     // 新增方法：用于派生类操作借阅记录
-    void addBorrowedBookId(int bookId) { borrowedBookIds.push_back(bookId); }
-    void incrementBorrowCount() { currentBorrowCount++; }
-    void decrementBorrowCount() { if (currentBorrowCount > 0) currentBorrowCount--; }
+    bool addBorrowedBookId(int bookId) { return borrowedBookIds.insert(bookId); }
+    bool removeBorrowedBookId(int bookId) { return borrowedBookIds.erase(bookId); }
     // void setId(const std::string& newId) { id = newId; }
     
 //获取借阅记录容器的引用
-    const std::vector<int>& getBorrowedBookIds() const { return borrowedBookIds; }
+    const SmallIntSet& getBorrowedBookIds() const { return borrowedBookIds; }
 }; // class Borrower
 
 #endif // BORROWER_H
\ No newline at end of file
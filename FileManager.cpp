@@ -1,77 +1,110 @@
 #include "FileManager.h"
 #include "Library.h"
+#include "LibraryJournal.h"
+#include "MappedFile.h"
+#include "TsvFormat.h"
 
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
 #include <fstream>
 #include <iostream>
+#include <iterator>
+#include <mutex>
 #include <sstream>
 #include <filesystem>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
 
 namespace {
 
-std::string escapeField(const std::string& s) {
-    std::string out;
-    out.reserve(s.size());
-    for (char c : s) {
-        if (c == '\t') out += "\\t";
-        else if (c == '\n') out += "\\n";
-        else out += c;
-    }
-    return out;
-}
+// 并行解析的线程数，0 表示取硬件并发数
+std::atomic<unsigned> loaderThreads{0};
+// 小于此大小的块不值得再分给其他线程
+constexpr std::size_t kMinChunkBytes = 256 * 1024;
 
-std::string unescapeField(const std::string& s) {
-    std::string out;
-    out.reserve(s.size());
-    for (size_t i = 0; i < s.size(); ++i) {
-        char c = s[i];
-        if (c == '\\' && i + 1 < s.size()) {
-            char next = s[++i];
-            if (next == 't') out += '\t';
-            else if (next == 'n') out += '\n';
-            else out += next;
-        } else {
-            out += c;
+struct ParseError {
+    std::size_t line;    // 块内行号（从 0 开始），合并时换算为文件行号
+    std::string message;
+};
+
+template <typename Record>
+struct ParsedChunk {
+    std::vector<Record> records;
+    std::vector<ParseError> errors;
+    std::size_t lines = 0;
+};
+
+// 逐行解析一个块（跳过空行，去掉行尾的 \r），行内容直接指向映射区。
+// parseLine(line, records) 成功时追加记录并返回 nullptr，失败时返回错误说明。
+template <typename Record, typename ParseLine>
+ParsedChunk<Record> parseChunk(std::string_view text, const ParseLine& parseLine) {
+    ParsedChunk<Record> chunk;
+    while (!text.empty()) {
+        std::size_t newline = text.find('\n');
+        std::string_view line = text.substr(0, newline);
+        text.remove_prefix(newline == std::string_view::npos ? text.size() : newline + 1);
+        if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+        if (!line.empty()) {
+            if (const char* error = parseLine(line, chunk.records)) {
+                chunk.errors.push_back(ParseError{chunk.lines, std::string(error) + ": " + std::string(line)});
+            }
         }
+        ++chunk.lines;
     }
-    return out;
+    return chunk;
 }
 
-bool tryParseInt(const std::string& text, int& value) {
-    try {
-        size_t idx = 0;
-        value = std::stoi(text, &idx);
-        return idx == text.size();
-    } catch (...) {
-        return false;
+// 按换行切成大致等长的块，每块以换行结尾（最后一块除外）
+std::vector<std::string_view> splitChunks(std::string_view text, std::size_t target) {
+    std::vector<std::string_view> chunks;
+    while (!text.empty()) {
+        std::size_t end = text.size();
+        if (target < text.size()) {
+            std::size_t newline = text.find('\n', target - 1);
+            if (newline != std::string_view::npos) end = newline + 1;
+        }
+        chunks.push_back(text.substr(0, end));
+        text.remove_prefix(end);
     }
+    return chunks;
 }
 
-std::vector<std::string> splitTsv(const std::string& line) {
-    std::vector<std::string> parts;
-    std::string current;
-    bool escape = false;
-    for (size_t i = 0; i < line.size(); ++i) {
-        char c = line[i];
-        if (!escape && c == '\t') {
-            parts.push_back(current);
-            current.clear();
-            continue;
-        }
-        if (!escape && c == '\\') {
-            escape = true;
-            continue;
+// 分块并行解析后按块顺序合并：记录顺序与文件一致，
+// 非法记录在全部解析完成后按行号顺序输出，与线程数无关。
+template <typename Record, typename ParseLine>
+void parseLines(std::string_view text, const std::string& filename, std::vector<Record>& out,
+                const ParseLine& parseLine) {
+    unsigned threads = loaderThreads.load();
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    std::size_t target = std::max(kMinChunkBytes, text.size() / (threads * 4) + 1);
+    std::vector<std::string_view> chunks = splitChunks(text, target);
+    std::vector<ParsedChunk<Record>> results(chunks.size());
+
+    std::atomic<std::size_t> next{0};
+    auto work = [&] {
+        for (std::size_t i; (i = next++) < chunks.size();) {
+            results[i] = parseChunk<Record>(chunks[i], parseLine);
         }
-        if (escape) {
-            if (c == 't') current.push_back('\t');
-            else if (c == 'n') current.push_back('\n');
-            else current.push_back(c);
-            escape = false;
-        } else {
-            current.push_back(c);
+    };
+    std::vector<std::thread> pool;
+    for (unsigned t = 1; t < threads && t < chunks.size(); ++t) pool.emplace_back(work);
+    work();
+    for (auto& thread : pool) thread.join();
+
+    std::size_t total = 0;
+    for (const auto& chunk : results) total += chunk.records.size();
+    out.reserve(total);
+    std::size_t firstLine = 1;
+    for (auto& chunk : results) {
+        std::move(chunk.records.begin(), chunk.records.end(), std::back_inserter(out));
+        for (const auto& error : chunk.errors) {
+            std::cerr << filename << ":" << firstLine + error.line << ": " << error.message << std::endl;
         }
+        firstLine += chunk.lines;
     }
-    parts.push_back(current);
-    return parts;
 }
 
 bool ensureParentDirectory(const std::string& filename) {
@@ -90,7 +123,8 @@ bool ensureParentDirectory(const std::string& filename) {
 }
 
 template <typename Writer>
-bool writeFileSafely(const std::string& filename, Writer&& writer, const char* description) {
+bool writeFileSafely(const std::string& filename, Writer&& writer, const char* description,
+                     std::ios::openmode mode = std::ios::trunc) {
     if (!ensureParentDirectory(filename)) {
         return false;
     }
@@ -99,7 +133,7 @@ bool writeFileSafely(const std::string& filename, Writer&& writer, const char* d
     std::filesystem::path tempPath = finalPath;
     tempPath += ".tmp";
 
-    std::ofstream stream(tempPath, std::ios::trunc);
+    std::ofstream stream(tempPath, mode);
     if (!stream.is_open()) {
         std::cerr << "无法打开临时文件用于写入 " << description << ": " << tempPath << std::endl;
         return false;
@@ -129,40 +163,210 @@ bool writeFileSafely(const std::string& filename, Writer&& writer, const char* d
     return true;
 }
 
-Borrower* createBorrowerFromParts(const std::vector<std::string>& parts) {
-    if (parts.size() < 6) return nullptr;
-    const std::string type = parts[0];
-    const std::string& id = parts[1];
-    const std::string& name = parts[2];
-    const std::string& dept = parts[3];
-    int limit = 0;
-    if (!tryParseInt(parts[4], limit)) return nullptr;
-    const std::string& extra = parts[5];
+// loginUser 的凭据索引：用户 ID -> users 文件中的一行（指向缓存的文件内容）。
+// 文件大小或修改时间变化、或经 saveBorrowersToFile 重写后重建；登录只做一次哈希查找，只为匹配的用户构造 Borrower
+struct CredentialRow {
+    std::string id;
+    std::string_view line;
+};
+
+struct CredentialCache {
+    std::mutex mutex;
+    bool valid = false;
+    std::string filename;
+    std::uintmax_t size = 0;
+    std::filesystem::file_time_type mtime{};
+    std::string contents;
+    std::unordered_map<std::string, std::string_view> rowById;
+};
+
+CredentialCache& credentialCache() {
+    static CredentialCache cache;
+    return cache;
+}
+
+// 需持有 cache.mutex
+bool refreshCredentials(CredentialCache& cache, const std::string& filename) {
+    std::error_code ec;
+    const auto size = std::filesystem::file_size(filename, ec);
+    const auto mtime = ec ? std::filesystem::file_time_type{} : std::filesystem::last_write_time(filename, ec);
+    if (!ec && cache.valid && cache.filename == filename && cache.size == size && cache.mtime == mtime) return true;
+
+    cache.valid = false;
+    cache.rowById.clear();
+    MappedFile file(filename);
+    if (ec || !file.isOpen()) {
+        std::cerr << "Cannot open " << filename << std::endl;
+        return false;
+    }
+    cache.contents.assign(file.contents());
+    std::vector<CredentialRow> rows;
+    // 与 tsv::parseBorrower 相同的校验，但不构造 Borrower
+    parseLines(std::string_view(cache.contents), filename, rows,
+               [](std::string_view line, std::vector<CredentialRow>& out) -> const char* {
+        std::string_view parts[tsv::kBorrowerFields];
+        int limit = 0;
+        if (tsv::split(line, parts, tsv::kBorrowerFields) < tsv::kBorrowerFields || !tsv::parseInt(parts[4], limit)) {
+            return "跳过非法用户记录";
+        }
+        const std::string_view type = parts[0];
+        if (type != "student" && type != "学生" && type != "teacher" && type != "教师") return "跳过非法用户记录";
+        out.push_back(CredentialRow{tsv::unescape(parts[1]), line});
+        return nullptr;
+    });
+    cache.rowById.reserve(rows.size());
+    for (auto& row : rows) {
+        cache.rowById.emplace(std::move(row.id), row.line); // ID 重复时取第一行
+    }
+    cache.filename = filename;
+    cache.size = size;
+    cache.mtime = mtime;
+    cache.valid = true;
+    return true;
+}
+
+void invalidateCredentials(const std::string& filename) {
+    CredentialCache& cache = credentialCache();
+    std::lock_guard<std::mutex> lock(cache.mutex);
+    if (cache.filename == filename) cache.valid = false;
+}
+
+// 二进制快照。布局（本机字节序，头部带字节序标记，不一致时拒绝载入）：
+//   SnapshotHeader
+//   字符串表：uint32 结束偏移[stringCount]，随后是全部字符串内容
+//   图书列：int32 ID、uint32 书名/作者/ISBN/分类的字符串下标、int32 总数、int32 可借数，各 bookCount 项
+//   借阅人列：uint8 类型、uint32 ID/姓名/院系/专业或职称的字符串下标、int32 借书上限、
+//             uint32 在借数，各 borrowerCount 项；随后是 int32 在借图书ID，共 loanCount 项
+// checksum 覆盖头部之后的全部字节。
+constexpr char kSnapshotMagic[8] = {'L', 'M', 'S', 'S', 'N', 'A', 'P', '\0'};
+constexpr std::uint32_t kSnapshotVersion = 1;
+constexpr std::uint32_t kSnapshotByteOrder = 0x01020304;
+
+enum : std::uint8_t { kSnapshotStudent = 0, kSnapshotTeacher = 1 };
 
-    if (type == "student" || type == "学生") {
-        return new Student(id, name, dept, extra, limit);
+struct SnapshotHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t byteOrder;
+    std::uint64_t stringCount;
+    std::uint64_t stringBytes;
+    std::uint64_t bookCount;
+    std::uint64_t borrowerCount;
+    std::uint64_t loanCount;
+    std::uint64_t checksum;
+};
+
+// 按 8 字节字处理的 FNV-1a 变体；每步都是双射，任意单个字被改动都能检出
+std::uint64_t snapshotChecksum(std::string_view data) {
+    std::uint64_t hash = 0xcbf29ce484222325ULL;
+    const std::uint64_t prime = 0x100000001b3ULL;
+    std::size_t i = 0;
+    for (; i + 8 <= data.size(); i += 8) {
+        std::uint64_t word;
+        std::memcpy(&word, data.data() + i, sizeof(word));
+        hash = (hash ^ word) * prime;
+    }
+    for (; i < data.size(); ++i) hash = (hash ^ static_cast<unsigned char>(data[i])) * prime;
+    return hash;
+}
+
+// 快照字符串表：作者与分类按驻留句柄去重，其他字段直接追加
+class StringTableBuilder {
+public:
+    std::uint32_t add(std::string_view text) {
+        bytes.append(text.data(), text.size());
+        ends.push_back(static_cast<std::uint32_t>(bytes.size()));
+        return static_cast<std::uint32_t>(ends.size() - 1);
     }
-    if (type == "teacher" || type == "教师") {
-        return new Teacher(id, name, dept, extra, limit);
+    std::uint32_t addShared(Symbol symbol) {
+        auto it = shared.find(symbol);
+        if (it != shared.end()) return it->second;
+        std::uint32_t index = add(symbol.view());
+        shared.emplace(symbol, index);
+        return index;
     }
-    return nullptr;
+    // 偏移以 uint32 保存，字符串总长不能超过 4GB
+    bool fits() const { return bytes.size() <= UINT32_MAX; }
+
+    std::vector<std::uint32_t> ends;
+    std::string bytes;
+
+private:
+    std::unordered_map<Symbol, std::uint32_t, Symbol::Hash> shared;
+};
+
+template <typename T>
+void appendColumn(std::string& out, const std::vector<T>& column) {
+    out.append(reinterpret_cast<const char*>(column.data()), column.size() * sizeof(T));
 }
 
+// 顺序读取各列，越界时置为失败并不再前进
+class SnapshotReader {
+public:
+    explicit SnapshotReader(std::string_view data) : data(data) {}
+
+    template <typename T>
+    bool readColumn(std::vector<T>& out, std::uint64_t count) {
+        if (!ok || count > (data.size() - pos) / sizeof(T)) return ok = false;
+        out.resize(static_cast<std::size_t>(count));
+        std::memcpy(out.data(), data.data() + pos, out.size() * sizeof(T));
+        pos += out.size() * sizeof(T);
+        return true;
+    }
+    bool readBytes(std::string_view& out, std::uint64_t count) {
+        if (!ok || count > data.size() - pos) return ok = false;
+        out = data.substr(pos, static_cast<std::size_t>(count));
+        pos += out.size();
+        return true;
+    }
+    bool finished() const { return ok && pos == data.size(); }
+
+private:
+    std::string_view data;
+    std::size_t pos = 0;
+    bool ok = true;
+};
+
+// 校验后的字符串表，按下标取出 string_view（指向映射区）
+class StringTable {
+public:
+    bool load(SnapshotReader& reader, std::uint64_t count, std::uint64_t byteCount) {
+        if (!reader.readColumn(ends, count) || !reader.readBytes(bytes, byteCount)) return false;
+        std::uint32_t previous = 0;
+        for (std::uint32_t end : ends) {
+            if (end < previous || end > bytes.size()) return false;
+            previous = end;
+        }
+        return true;
+    }
+    bool valid(const std::vector<std::uint32_t>& indices) const {
+        return std::all_of(indices.begin(), indices.end(), [this](std::uint32_t i) { return i < ends.size(); });
+    }
+    std::string_view at(std::uint32_t index) const {
+        std::uint32_t begin = index == 0 ? 0 : ends[index - 1];
+        return bytes.substr(begin, ends[index] - begin);
+    }
+
+private:
+    std::vector<std::uint32_t> ends;
+    std::string_view bytes;
+};
+
 } // namespace
 
-bool FileManager::saveBooksToFile(const std::vector<Book>& books, const std::string& filename) {
+void FileManager::setLoaderThreads(unsigned threads) {
+    loaderThreads.store(threads);
+}
+
+bool FileManager::saveBooksToFile(const BookStore& books, const std::string& filename) {
     bool succeeded = writeFileSafely(
         filename,
         [&books](std::ofstream& stream) {
+            tsv::BufferedWriter out(stream);
             for (const auto& book : books) {
-                stream << book.getBookId() << '\t'
-                       << escapeField(book.getTitle()) << '\t'
-                       << escapeField(book.getAuthor()) << '\t'
-                       << escapeField(book.getIsbn()) << '\t'
-                       << escapeField(book.getCategory()) << '\t'
-                       << book.getTotalCopies() << '\t'
-                       << book.getAvailableCopies() << '\n';
+                out.writeBook(book);
             }
+            out.flush();
         },
         "图书数据");
     if (succeeded) {
@@ -172,86 +376,59 @@ bool FileManager::saveBooksToFile(const std::vector<Book>& books, const std::str
 }
 
 bool FileManager::loadBooksFromFile(std::vector<Book>& books, const std::string& filename) {
-    std::ifstream stream(filename);
-    if (!stream.is_open()) {
+    MappedFile file(filename);
+    if (!file.isOpen()) {
         std::cerr << "Cannot open " << filename << std::endl;
         return false;
     }
     books.clear();
-    std::string line;
-    while (std::getline(stream, line)) {
-        if (line.empty()) continue;
-        auto parts = splitTsv(line);
-        if (parts.size() < 7) {
-            std::cerr << "跳过非法图书记录: " << line << std::endl;
-            continue;
+    parseLines(file.contents(), filename, books, [](std::string_view line, std::vector<Book>& out) -> const char* {
+        const char* error = nullptr;
+        auto book = tsv::parseBook(line, error);
+        if (!book) {
+            return error;
         }
-        int id = 0, total = 0, available = 0;
-        if (!tryParseInt(parts[0], id) || !tryParseInt(parts[5], total) || !tryParseInt(parts[6], available)) {
-            std::cerr << "解析图书数字字段失败，记录已跳过: " << line << std::endl;
-            continue;
-        }
-        Book book(id, unescapeField(parts[1]), unescapeField(parts[2]),
-                  unescapeField(parts[3]), unescapeField(parts[4]), total);
-        int borrowed = total - available;
-        for (int i = 0; i < borrowed; ++i) book.borrowBook();
-        books.push_back(book);
-    }
+        out.push_back(std::move(*book));
+        return nullptr;
+    });
     std::cout << "Loaded books from " << filename << std::endl;
     return true;
 }
 
-bool FileManager::saveBorrowersToFile(const std::vector<Borrower*>& borrowers, const std::string& filename) {
+bool FileManager::saveBorrowersToFile(const std::vector<std::unique_ptr<Borrower>>& borrowers, const std::string& filename) {
     bool succeeded = writeFileSafely(
         filename,
         [&borrowers](std::ofstream& stream) {
-            for (auto borrower : borrowers) {
+            tsv::BufferedWriter out(stream);
+            for (const auto& borrower : borrowers) {
                 if (!borrower) continue;
-                std::string extra;
-                if (borrower->getType() == "学生") {
-                    if (const auto* stu = dynamic_cast<const Student*>(borrower)) {
-                        extra = stu->getMajor();
-                    }
-                } else if (borrower->getType() == "教师") {
-                    if (const auto* teacher = dynamic_cast<const Teacher*>(borrower)) {
-                        extra = teacher->getTitle();
-                    }
-                }
-                stream << escapeField(borrower->getType()) << '\t'
-                       << escapeField(borrower->getId()) << '\t'
-                       << escapeField(borrower->getName()) << '\t'
-                       << escapeField(borrower->getDepartment()) << '\t'
-                       << borrower->getMaxBorrowLimit() << '\t'
-                       << escapeField(extra) << '\n';
+                out.writeBorrower(*borrower);
             }
+            out.flush();
         },
         "用户数据");
+    invalidateCredentials(filename); // 修改时间的精度不足以区分紧接着的两次写出
     if (succeeded) {
         std::cout << "Saved users to " << filename << std::endl;
     }
     return succeeded;
 }
 
-bool FileManager::loadBorrowersFromFile(std::vector<Borrower*>& borrowers, const std::string& filename) {
-    std::ifstream stream(filename);
-    if (!stream.is_open()) {
+bool FileManager::loadBorrowersFromFile(std::vector<std::unique_ptr<Borrower>>& borrowers, const std::string& filename) {
+    MappedFile file(filename);
+    if (!file.isOpen()) {
         std::cerr << "Cannot open " << filename << std::endl;
         return false;
     }
-    for (auto borrower : borrowers) delete borrower;
     borrowers.clear();
 
-    std::string line;
-    while (std::getline(stream, line)) {
-        if (line.empty()) continue;
-        auto parts = splitTsv(line);
-        for (auto& part : parts) part = unescapeField(part);
-        if (Borrower* borrower = createBorrowerFromParts(parts)) {
-            borrowers.push_back(borrower);
-        } else {
-            std::cerr << "跳过非法用户记录: " << line << std::endl;
-        }
-    }
+    parseLines(file.contents(), filename, borrowers,
+               [](std::string_view line, std::vector<std::unique_ptr<Borrower>>& out) -> const char* {
+        auto borrower = tsv::parseBorrower(line);
+        if (!borrower) return "跳过非法用户记录";
+        out.push_back(std::move(borrower));
+        return nullptr;
+    });
     std::cout << "Loaded users from " << filename << std::endl;
     return true;
 }
@@ -260,26 +437,18 @@ Borrower* FileManager::loginUser(const std::string& filename, const std::string&
     std::string expected = id.substr(std::max(0, static_cast<int>(id.length()) - 6));
     if (password != expected) return nullptr;
 
-    std::vector<Borrower*> users;
-    if (!loadBorrowersFromFile(users, filename)) return nullptr;
-
-    Borrower* found = nullptr;
-    for (auto user : users) {
-        if (user && user->getId() == id) {
-            found = user;
-            break;
-        }
-    }
-    for (auto user : users) {
-        if (user != nullptr && user != found) delete user;
-    }
-    users.clear();
-    return found;
+    CredentialCache& cache = credentialCache();
+    std::lock_guard<std::mutex> lock(cache.mutex);
+    if (!refreshCredentials(cache, filename)) return nullptr;
+    auto it = cache.rowById.find(id);
+    if (it == cache.rowById.end()) return nullptr;
+    return tsv::parseBorrower(it->second).release(); // 调用方负责释放
 }
 
 bool FileManager::saveLibrarySnapshot(const Library& library,
                                       const std::string& booksFile,
                                       const std::string& usersFile) {
+    auto readLock = library.readLock(); // 两个文件写自同一时刻的目录
     bool booksOk = saveBooksToFile(library.getBooks(), booksFile);
     bool usersOk = saveBorrowersToFile(library.getBorrowers(), usersFile);
     if (!booksOk || !usersOk) {
@@ -291,25 +460,254 @@ bool FileManager::saveLibrarySnapshot(const Library& library,
     return booksOk && usersOk;
 }
 
+bool FileManager::saveLibraryChanges(Library& library,
+                                     const std::string& booksFile,
+                                     const std::string& usersFile) {
+    LibraryChangeSet changes = library.takeChanges();
+    std::error_code ec;
+    const bool writeBooks = changes.booksChanged() || !std::filesystem::exists(booksFile, ec);
+    const bool writeUsers = changes.borrowersChanged() || !std::filesystem::exists(usersFile, ec);
+    if (!writeBooks && !writeUsers) return true;
+
+    bool booksOk = true;
+    bool usersOk = true;
+    {
+        auto readLock = library.readLock();
+        if (writeBooks) booksOk = saveBooksToFile(library.getBooks(), booksFile);
+        if (writeUsers) usersOk = saveBorrowersToFile(library.getBorrowers(), usersFile);
+    }
+    if (!booksOk || !usersOk) {
+        // 只放回写出失败一侧的记录，下次保存时重试
+        if (booksOk) {
+            changes.books.clear();
+            changes.removedBooks.clear();
+        }
+        if (usersOk) {
+            changes.borrowers.clear();
+            changes.removedBorrowers.clear();
+        }
+        library.restoreChanges(changes);
+        std::cerr << "保存图书馆修改失败: " << (booksOk ? "" : "图书写入失败 ")
+                  << (usersOk ? "" : "用户写入失败") << std::endl;
+        return false;
+    }
+    std::cout << "Library changes saved to " << (writeBooks ? booksFile : "")
+              << (writeBooks && writeUsers ? " / " : "") << (writeUsers ? usersFile : "") << std::endl;
+    return true;
+}
+
 bool FileManager::loadLibrarySnapshot(Library& library,
                                       const std::string& booksFile,
-                                      const std::string& usersFile) {
+                                      const std::string& usersFile,
+                                      const std::string& journalFile) {
     std::vector<Book> loadedBooks;
-    std::vector<Borrower*> loadedBorrowers;
+    std::vector<std::unique_ptr<Borrower>> loadedBorrowers;
 
     bool booksOk = loadBooksFromFile(loadedBooks, booksFile);
     bool usersOk = loadBorrowersFromFile(loadedBorrowers, usersFile);
 
     if (!booksOk || !usersOk) {
-        for (auto borrower : loadedBorrowers) delete borrower;
-        loadedBorrowers.clear();
         std::cerr << "加载图书馆快照失败: " << (booksOk ? "" : "图书读取失败 ")
                   << (usersOk ? "" : "用户读取失败") << std::endl;
         return false;
     }
 
     library.setBooks(loadedBooks);
-    library.setBorrowers(loadedBorrowers);
+    library.setBorrowers(std::move(loadedBorrowers));
+    if (!journalFile.empty()) {
+        LibraryJournal::replay(library, journalFile, booksFile, usersFile);
+    }
     std::cout << "Library snapshot loaded from " << booksFile << " / " << usersFile << std::endl;
     return true;
 }
+
+bool FileManager::saveBinarySnapshot(const Library& library, const std::string& filename) {
+    StringTableBuilder strings;
+    std::vector<std::int32_t> ids, totals, availables;
+    std::vector<std::uint32_t> titles, authors, isbns, categories;
+    std::vector<std::uint8_t> types;
+    std::vector<std::uint32_t> borrowerIds, names, departments, extras, loanCounts;
+    std::vector<std::int32_t> limits, loanBookIds;
+    {
+        // 借还只持有共享锁，在分片锁下修改借阅人的在借集合；这里取独占锁，
+        // 使可借数与在借记录取自同一时刻。编码与写文件在锁外进行
+        auto exclusive = library.writeLock();
+        const BookStore& books = library.getBooks();
+        const auto& borrowers = library.getBorrowers();
+        ids.reserve(books.size());
+        totals.reserve(books.size());
+        availables.reserve(books.size());
+        titles.reserve(books.size());
+        authors.reserve(books.size());
+        isbns.reserve(books.size());
+        categories.reserve(books.size());
+        for (const auto& book : books) {
+            ids.push_back(book.getBookId());
+            titles.push_back(strings.add(book.getTitle()));
+            authors.push_back(strings.addShared(book.getAuthorSymbol()));
+            isbns.push_back(strings.add(book.getIsbn()));
+            categories.push_back(strings.addShared(book.getCategorySymbol()));
+            totals.push_back(book.getTotalCopies());
+            availables.push_back(book.getAvailableCopies());
+        }
+
+        for (const auto& borrower : borrowers) {
+            if (!borrower) continue;
+            std::string_view extra;
+            if (const auto* stu = dynamic_cast<const Student*>(borrower.get())) {
+                types.push_back(kSnapshotStudent);
+                extra = stu->getMajor();
+            } else if (const auto* teacher = dynamic_cast<const Teacher*>(borrower.get())) {
+                types.push_back(kSnapshotTeacher);
+                extra = teacher->getTitle();
+            } else {
+                continue;
+            }
+            borrowerIds.push_back(strings.add(borrower->getId()));
+            names.push_back(strings.add(borrower->getName()));
+            departments.push_back(strings.add(borrower->getDepartment()));
+            extras.push_back(strings.add(extra));
+            limits.push_back(borrower->getMaxBorrowLimit());
+            const SmallIntSet& borrowed = borrower->getBorrowedBookIds();
+            loanCounts.push_back(static_cast<std::uint32_t>(borrowed.size()));
+            loanBookIds.insert(loanBookIds.end(), borrowed.begin(), borrowed.end());
+        }
+    }
+    if (!strings.fits()) {
+        std::cerr << "二进制快照字符串总长超出限制: " << filename << std::endl;
+        return false;
+    }
+
+    std::string body;
+    appendColumn(body, strings.ends);
+    body += strings.bytes;
+    appendColumn(body, ids);
+    appendColumn(body, titles);
+    appendColumn(body, authors);
+    appendColumn(body, isbns);
+    appendColumn(body, categories);
+    appendColumn(body, totals);
+    appendColumn(body, availables);
+    appendColumn(body, types);
+    appendColumn(body, borrowerIds);
+    appendColumn(body, names);
+    appendColumn(body, departments);
+    appendColumn(body, extras);
+    appendColumn(body, limits);
+    appendColumn(body, loanCounts);
+    appendColumn(body, loanBookIds);
+
+    SnapshotHeader header{};
+    std::memcpy(header.magic, kSnapshotMagic, sizeof(header.magic));
+    header.version = kSnapshotVersion;
+    header.byteOrder = kSnapshotByteOrder;
+    header.stringCount = strings.ends.size();
+    header.stringBytes = strings.bytes.size();
+    header.bookCount = ids.size();
+    header.borrowerCount = types.size();
+    header.loanCount = loanBookIds.size();
+    header.checksum = snapshotChecksum(body);
+
+    bool succeeded = writeFileSafely(
+        filename,
+        [&](std::ofstream& stream) {
+            stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            stream.write(body.data(), static_cast<std::streamsize>(body.size()));
+        },
+        "二进制快照", std::ios::trunc | std::ios::binary);
+    if (succeeded) {
+        std::cout << "Binary snapshot saved to " << filename << std::endl;
+    }
+    return succeeded;
+}
+
+bool FileManager::loadBinarySnapshot(Library& library, const std::string& filename) {
+    MappedFile file(filename);
+    if (!file.isOpen()) {
+        std::cerr << "Cannot open " << filename << std::endl;
+        return false;
+    }
+    auto fail = [&filename](const char* reason) {
+        std::cerr << "加载二进制快照失败（" << reason << "）: " << filename << std::endl;
+        return false;
+    };
+
+    std::string_view contents = file.contents();
+    SnapshotHeader header;
+    if (contents.size() < sizeof(header)) return fail("文件过短");
+    std::memcpy(&header, contents.data(), sizeof(header));
+    if (std::memcmp(header.magic, kSnapshotMagic, sizeof(header.magic)) != 0) return fail("不是快照文件");
+    if (header.version != kSnapshotVersion) return fail("不支持的版本");
+    if (header.byteOrder != kSnapshotByteOrder) return fail("字节序不匹配");
+    std::string_view body = contents.substr(sizeof(header));
+    if (snapshotChecksum(body) != header.checksum) return fail("校验和不匹配");
+
+    SnapshotReader reader(body);
+    StringTable strings;
+    std::vector<std::int32_t> ids, totals, availables, limits, loanBookIds;
+    std::vector<std::uint32_t> titles, authors, isbns, categories;
+    std::vector<std::uint8_t> types;
+    std::vector<std::uint32_t> borrowerIds, names, departments, extras, loanCounts;
+    const std::uint64_t bookCount = header.bookCount;
+    const std::uint64_t borrowerCount = header.borrowerCount;
+    bool complete = strings.load(reader, header.stringCount, header.stringBytes) &&
+                    reader.readColumn(ids, bookCount) && reader.readColumn(titles, bookCount) &&
+                    reader.readColumn(authors, bookCount) && reader.readColumn(isbns, bookCount) &&
+                    reader.readColumn(categories, bookCount) && reader.readColumn(totals, bookCount) &&
+                    reader.readColumn(availables, bookCount) &&
+                    reader.readColumn(types, borrowerCount) && reader.readColumn(borrowerIds, borrowerCount) &&
+                    reader.readColumn(names, borrowerCount) && reader.readColumn(departments, borrowerCount) &&
+                    reader.readColumn(extras, borrowerCount) && reader.readColumn(limits, borrowerCount) &&
+                    reader.readColumn(loanCounts, borrowerCount) &&
+                    reader.readColumn(loanBookIds, header.loanCount);
+    if (!complete || !reader.finished()) return fail("数据长度不符");
+    for (const auto* column : {&titles, &authors, &isbns, &categories, &borrowerIds, &names, &departments, &extras}) {
+        if (!strings.valid(*column)) return fail("字符串下标越界");
+    }
+    std::uint64_t loanTotal = 0;
+    for (std::uint32_t count : loanCounts) loanTotal += count;
+    if (loanTotal != header.loanCount) return fail("在借记录数不符");
+
+    std::vector<Book> books;
+    books.reserve(ids.size());
+    for (std::size_t i = 0; i < ids.size(); ++i) {
+        auto book = Book::withCounts(ids[i], std::string(strings.at(titles[i])), std::string(strings.at(authors[i])),
+                                     std::string(strings.at(isbns[i])), std::string(strings.at(categories[i])),
+                                     totals[i], availables[i]);
+        if (!book) return fail("图书副本数不合法");
+        books.push_back(std::move(*book));
+    }
+
+    std::vector<std::unique_ptr<Borrower>> borrowers;
+    borrowers.reserve(types.size());
+    for (std::size_t i = 0; i < types.size(); ++i) {
+        const std::string id(strings.at(borrowerIds[i]));
+        const std::string name(strings.at(names[i]));
+        const std::string department(strings.at(departments[i]));
+        const std::string extra(strings.at(extras[i]));
+        if (types[i] == kSnapshotStudent) {
+            borrowers.push_back(std::make_unique<Student>(id, name, department, extra, limits[i]));
+        } else if (types[i] == kSnapshotTeacher) {
+            borrowers.push_back(std::make_unique<Teacher>(id, name, department, extra, limits[i]));
+        } else {
+            return fail("未知的借阅人类型");
+        }
+    }
+
+    library.setBooks(books);
+    library.setBorrowers(std::move(borrowers));
+    // 图书的可借数已计入借出的副本，再把这些副本归属回借阅人
+    std::size_t next = 0;
+    std::size_t orphaned = 0;
+    for (std::size_t i = 0; i < types.size(); ++i) {
+        const std::string id(strings.at(borrowerIds[i]));
+        for (std::uint32_t k = 0; k < loanCounts[i]; ++k) {
+            if (library.assignOutstandingLoan(id, loanBookIds[next++]) != LoanResult::Ok) ++orphaned;
+        }
+    }
+    if (orphaned > 0) {
+        std::cerr << "二进制快照中有 " << orphaned << " 条借阅记录无法恢复" << std::endl;
+    }
+    std::cout << "Binary snapshot loaded from " << filename << std::endl;
+    return true;
+}
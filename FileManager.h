@@ -1,9 +1,11 @@
 #ifndef FILEMANAGER_H
 #define FILEMANAGER_H
 
+#include <memory>
 #include <string>
 #include <vector>
 #include "Book.h"
+#include "BookStore.h"
 #include "Borrower.h"
 #include "Student.h"
 #include "Teacher.h"
@@ -13,23 +15,41 @@ class Library;
 class FileManager {
 public:
     // 图书数据文件操作
-    static bool saveBooksToFile(const std::vector<Book>& books, const std::string& filename);
+    static bool saveBooksToFile(const BookStore& books, const std::string& filename);
     static bool loadBooksFromFile(std::vector<Book>& books, const std::string& filename);
     
+    // 载入大文件时分块并行解析的线程数；0（默认）表示取硬件并发数
+    static void setLoaderThreads(unsigned threads);
+    
     // 用户数据文件操作
-    static bool saveBorrowersToFile(const std::vector<Borrower*>& borrowers, const std::string& filename);
-    static bool loadBorrowersFromFile(std::vector<Borrower*>& borrowers, const std::string& filename);
+    static bool saveBorrowersToFile(const std::vector<std::unique_ptr<Borrower>>& borrowers, const std::string& filename);
+    static bool loadBorrowersFromFile(std::vector<std::unique_ptr<Borrower>>& borrowers, const std::string& filename);
     
-    // 登录功能
+    // 登录功能：按用户 ID 索引 users 文件并缓存，文件大小或修改时间变化后重建索引；
+    // 返回新构造的借阅人，调用方负责释放
     static Borrower* loginUser(const std::string& filename, const std::string& id, const std::string& password);
 
     // 统一快照
     static bool saveLibrarySnapshot(const Library& library,
                                     const std::string& booksFile,
                                     const std::string& usersFile);
+    // 增量保存：只重写自上次保存以来有修改的文件（文件不存在时照常写出），未修改的文件不动。
+    // 修改记录取自 Library::takeChanges()，应总是保存到同一对文件
+    static bool saveLibraryChanges(Library& library,
+                                   const std::string& booksFile,
+                                   const std::string& usersFile);
+    // journalFile 非空时，载入后重放 LibraryJournal 中与快照匹配的记录；
+    // 此时 library 上不应挂着正在记录的日志，否则重放的修改会再次写入日志
     static bool loadLibrarySnapshot(Library& library,
                                     const std::string& booksFile,
-                                    const std::string& usersFile);
+                                    const std::string& usersFile,
+                                    const std::string& journalFile = "");
+
+    // 二进制快照：单文件保存图书、借阅人及其在借图书，带版本号与校验和。
+    // 字符串集中存放在字符串表，数值按列定长存放，载入时无需解析文本。
+    // TSV 仍用于导入导出。
+    static bool saveBinarySnapshot(const Library& library, const std::string& filename);
+    static bool loadBinarySnapshot(Library& library, const std::string& filename);
 };
 
 #endif // FILEMANAGER_H
\ No newline at end of file
@@ -1,102 +1,341 @@
 #include "Library.h"
 #include <iostream>
 #include <algorithm>
+#include <cassert>
+#include <functional>
 #include "Borrower.h"
+#include "LibraryLog.h"
+#include "Student.h"
+#include "Teacher.h"
+
+namespace {
+
+std::size_t titleHash(std::string_view title) {
+    return std::hash<std::string_view>()(title);
+}
+
+// 用桶尾覆盖 position 后弹出，桶内不再保持插入顺序；返回移入 position 的槽位
+std::size_t eraseSlot(std::vector<std::size_t>& slots, std::size_t position) {
+    std::size_t moved = slots.back();
+    slots[position] = moved;
+    slots.pop_back();
+    return moved;
+}
+
+} // namespace
 
 Library::Library() : libraryName("默认图书馆"), location("未知位置"), totalBooks(0), availableBooks(0) {}
 
 Library::Library(const std::string& name, const std::string& location)
     : libraryName(name), location(location), totalBooks(0), availableBooks(0) {}
 
-void Library::addBook(const Book& book) {
-    books.push_back(book);
-    updateStatistics(); 
-    std::cout << "图书《" << book.getTitle() << "》已添加到图书馆" << std::endl;
+bool Library::addBook(const Book& book) {
+    std::unique_lock<std::shared_mutex> lock(catalogueMutex);
+    if (bookSlotById.count(book.getBookId()) != 0) {
+        LibraryLog::warn("添加失败：ID为 ", book.getBookId(), " 的图书已存在");
+        return false;
+    }
+    std::size_t slot = insertBook(book);
+    removedBookIds.erase(book.getBookId());
+    markBookChanged(slot, book.getBookId());
+    checkStatistics();
+    LibraryLog::info("图书《", book.getTitle(), "》已添加到图书馆");
+    notify({LibraryChange::Kind::AddBook, book.getBookId(), {}, &books.at(slot), nullptr});
+    return true;
+}
+
+std::size_t Library::addBooks(const std::vector<Book>& newBooks) {
+    std::unique_lock<std::shared_mutex> lock(catalogueMutex);
+    std::size_t added = 0;
+    for (const auto& book : newBooks) {
+        if (bookSlotById.count(book.getBookId()) != 0) continue;
+        std::size_t slot = insertBook(book);
+        removedBookIds.erase(book.getBookId());
+        markBookChanged(slot, book.getBookId());
+        notify({LibraryChange::Kind::AddBook, book.getBookId(), {}, &books.at(slot), nullptr});
+        ++added;
+    }
+    checkStatistics();
+    LibraryLog::info("批量添加图书 ", added, " 本，跳过已存在的ID ", newBooks.size() - added, " 个");
+    return added;
+}
+
+bool Library::updateBook(int bookId, const Book& updated) {
+    std::unique_lock<std::shared_mutex> lock(catalogueMutex);
+    auto it = bookSlotById.find(bookId);
+    if (it == bookSlotById.end()) {
+        LibraryLog::warn("未找到ID为 ", bookId, " 的图书");
+        return false;
+    }
+    const std::size_t slot = it->second;
+    const int newId = updated.getBookId();
+    const int onLoan = books.at(slot).getTotalCopies() - books.at(slot).getAvailableCopies();
+    if (newId != bookId && bookSlotById.count(newId) != 0) {
+        LibraryLog::warn("修改失败：ID为 ", newId, " 的图书已存在");
+        return false;
+    }
+    if (newId != bookId && onLoan > 0) {
+        LibraryLog::warn("修改失败：图书 ", bookId, " 有 ", onLoan, " 本未归还，不能修改ID");
+        return false;
+    }
+    auto replacement = Book::withCounts(newId, updated.getTitle(), updated.getAuthor(), updated.getIsbn(),
+                                        updated.getCategory(), updated.getTotalCopies(),
+                                        updated.getTotalCopies() - onLoan);
+    if (!replacement) {
+        LibraryLog::warn("修改失败：图书 ", bookId, " 有 ", onLoan, " 本未归还，总数不能少于此数");
+        return false;
+    }
+
+    // 槽位与在借表不动，只替换内容并重建索引与统计
+    unindexBook(slot);
+    accountBook(books.at(slot), -1);
+    books.at(slot) = std::move(*replacement);
+    books.syncCounts(slot);
+    indexBook(slot);
+    accountBook(books.at(slot), +1);
+    if (newId != bookId) {
+        bookSlotById.erase(it);
+        bookSlotById[newId] = slot;
+        shardOf(slot).changedBooks.erase(bookId);
+        removedBookIds.insert(bookId);
+        removedBookIds.erase(newId);
+    }
+    markBookChanged(slot, newId);
+    checkStatistics();
+    LibraryLog::info("图书《", books.at(slot).getTitle(), "》信息已更新");
+    // 日志按删除后重新加入记录；重放时按可借数重新登记在借副本
+    notify({LibraryChange::Kind::RemoveBook, bookId, {}, nullptr, nullptr});
+    notify({LibraryChange::Kind::AddBook, newId, {}, &books.at(slot), nullptr});
+    return true;
 }
 
 bool Library::removeBook(int bookId) {
-    auto it = std::find_if(books.begin(), books.end(),
-        [bookId](const Book& book) { return book.getBookId() == bookId; });
+    std::unique_lock<std::shared_mutex> lock(catalogueMutex);
+    auto it = bookSlotById.find(bookId);
     
-    if (it != books.end()) {
-        std::cout << "图书《" << it->getTitle() << "》已从图书馆移除" << std::endl;
-        books.erase(it);
-        updateStatistics();
+    if (it != bookSlotById.end()) {
+        LibraryLog::info("图书《", books.at(it->second).getTitle(), "》已从图书馆移除");
+        unindexBook(it->second);
+        accountBook(books.at(it->second), -1);
+        shardOf(it->second).loans.clearSlot(it->second / kLockShards);
+        shardOf(it->second).changedBooks.erase(bookId);
+        removedBookIds.insert(bookId);
+        books.erase(it->second);
+        bookSlotById.erase(it);
+        checkStatistics();
+        notify({LibraryChange::Kind::RemoveBook, bookId, {}, nullptr, nullptr});
         return true;
     }
     
-    std::cout << "未找到ID为 " << bookId << " 的图书" << std::endl;
+    LibraryLog::warn("未找到ID为 ", bookId, " 的图书");
     return false;
 }
 
 Book* Library::findBookById(int bookId) {
-    auto it = std::find_if(books.begin(), books.end(),
-        [bookId](const Book& book) { return book.getBookId() == bookId; });
-    
-    return (it != books.end()) ? &(*it) : nullptr;
+    std::shared_lock<std::shared_mutex> lock(catalogueMutex);
+    auto it = bookSlotById.find(bookId);
+    return (it != bookSlotById.end()) ? &books.at(it->second) : nullptr;
 }
 
-Book* Library::findBookByTitle(const std::string& title) {
-    auto it = std::find_if(books.begin(), books.end(),
-        [&title](const Book& book) { return book.getTitle() == title; });
-    
-    return (it != books.end()) ? &(*it) : nullptr;
+const Book* Library::findBookById(int bookId) const {
+    std::shared_lock<std::shared_mutex> lock(catalogueMutex);
+    auto it = bookSlotById.find(bookId);
+    return (it != bookSlotById.end()) ? &books.at(it->second) : nullptr;
 }
 
-std::vector<Book*> Library::findBooksByCategory(const std::string& category) {
-    std::vector<Book*> result;
-    for (auto& book : books) {
-        if (book.getCategory() == category) {
-            result.push_back(&book);
+BookHandle Library::handleOf(int bookId) const {
+    std::shared_lock<std::shared_mutex> lock(catalogueMutex);
+    auto it = bookSlotById.find(bookId);
+    return (it != bookSlotById.end()) ? books.handleAt(it->second) : BookHandle();
+}
+
+Book* Library::resolve(BookHandle handle) {
+    std::shared_lock<std::shared_mutex> lock(catalogueMutex);
+    return books.resolve(handle);
+}
+
+const Book* Library::resolve(BookHandle handle) const {
+    std::shared_lock<std::shared_mutex> lock(catalogueMutex);
+    return books.resolve(handle);
+}
+
+Book* Library::findBookByTitle(std::string_view title) {
+    std::shared_lock<std::shared_mutex> lock(catalogueMutex);
+    std::size_t slot = titleIndex.find(titleHash(title),
+        [&](std::size_t candidate) { return books.at(candidate).getTitle() == title; });
+    return slot != TitleIndex::npos ? &books.at(slot) : nullptr;
+}
+
+std::vector<Book*> Library::findBooksByCategory(std::string_view category) {
+    Symbol symbol = StringPool::global().find(category);
+    if (!symbol.valid()) return {};
+    std::shared_lock<std::shared_mutex> lock(catalogueMutex);
+    auto it = slotsByCategory.find(symbol);
+    return booksAtSlots(it != slotsByCategory.end() ? &it->second : nullptr);
+}
+
+std::vector<Book*> Library::findBooksByAuthor(std::string_view author) {
+    Symbol symbol = StringPool::global().find(author);
+    if (!symbol.valid()) return {};
+    std::shared_lock<std::shared_mutex> lock(catalogueMutex);
+    auto it = slotsByAuthor.find(symbol);
+    return booksAtSlots(it != slotsByAuthor.end() ? &it->second : nullptr);
+}
+
+const char* loanResultMessage(LoanResult result) {
+    switch (result) {
+        case LoanResult::Ok: return "操作成功";
+        case LoanResult::BorrowerNotFound: return "未找到该借阅人";
+        case LoanResult::BookNotFound: return "未找到该图书";
+        case LoanResult::InvalidDays: return "借阅天数必须大于0";
+        case LoanResult::LimitReached: return "已达到借书上限";
+        case LoanResult::AlreadyBorrowed: return "已借阅过该图书";
+        case LoanResult::NoCopiesAvailable: return "该图书暂无可借副本";
+        case LoanResult::NotBorrowed: return "未借阅过该图书";
+    }
+    return "未知错误";
+}
+
+std::mutex& Library::borrowerMutex(const std::string& borrowerId) const {
+    return borrowerShards[std::hash<std::string>()(borrowerId) % kLockShards].mutex;
+}
+
+bool Library::lendSlot(std::size_t slot) {
+    Book& book = books.at(slot);
+    const bool wasAvailable = book.getIsAvailable();
+    if (!book.borrowBook()) return false;
+    books.syncCounts(slot);
+    shardOf(slot).loans.add(slot / kLockShards);
+    accountLoan(book, -1, wasAvailable);
+    return true;
+}
+
+bool Library::receiveSlot(std::size_t slot) {
+    if (shardOf(slot).loans.loansFor(slot / kLockShards) <= 0) return false;
+    Book& book = books.at(slot);
+    const bool wasAvailable = book.getIsAvailable();
+    if (!book.returnBook()) return false;
+    books.syncCounts(slot);
+    shardOf(slot).loans.remove(slot / kLockShards);
+    accountLoan(book, +1, wasAvailable);
+    return true;
+}
+
+// 借还只改变可借数：不经过 accountBook 的先减后加，避免其他线程读到总数的中间值
+void Library::accountLoan(const Book& book, int copyDelta, bool wasAvailable) {
+    availableCopies += copyDelta;
+    if (wasAvailable != book.getIsAvailable()) availableBooks += wasAvailable ? -1 : 1;
+    auto counters = categoryCounters.find(book.getCategorySymbol());
+    if (counters != categoryCounters.end()) counters->second.availableCopies += copyDelta;
+}
+
+LoanResult Library::lendToBorrower(Borrower& borrower, int bookId, std::size_t slot) {
+    if (!borrower.canBorrowMore()) return LoanResult::LimitReached;
+    if (borrower.hasBorrowedBook(bookId)) return LoanResult::AlreadyBorrowed;
+    if (!lendSlot(slot)) return LoanResult::NoCopiesAvailable;
+    borrower.addBorrowedBookId(bookId);
+    borrower.addToBorrowHistory(bookId, BorrowAction::Borrow);
+    return LoanResult::Ok;
+}
+
+LoanResult Library::checkout(const std::string& borrowerId, int bookId, int days) {
+    std::shared_lock<std::shared_mutex> lock(catalogueMutex);
+    LoanResult result = LoanResult::Ok;
+    auto borrowerIt = borrowerIndexById.find(borrowerId);
+    auto bookIt = bookSlotById.find(bookId);
+    Borrower* borrower = borrowerIt != borrowerIndexById.end() ? borrowers[borrowerIt->second].get() : nullptr;
+    if (days <= 0) result = LoanResult::InvalidDays;
+    else if (!borrower) result = LoanResult::BorrowerNotFound;
+    else if (bookIt == bookSlotById.end()) result = LoanResult::BookNotFound;
+    else {
+        // 只锁定该借阅人与该图书所在的分片
+        std::scoped_lock<std::mutex, std::mutex> shards(borrowerMutex(borrowerId), shardOf(bookIt->second).mutex);
+        result = lendToBorrower(*borrower, bookId, bookIt->second);
+        if (result == LoanResult::Ok) {
+            markBookChanged(bookIt->second, bookId);
+            // 在分片锁内通知，同一本书或同一借阅人的记录顺序与实际发生顺序一致
+            notify({LibraryChange::Kind::Checkout, bookId, borrowerId, nullptr, borrower});
+            LibraryLog::info("借书成功: ", borrower->getType(), " ", borrower->getName(), " 成功借阅《",
+                             books.at(bookIt->second).getTitle(), "》 (", borrower->getCurrentBorrowCount(), "/",
+                             borrower->getMaxBorrowLimit(), ")");
+            return result;
         }
     }
+    LibraryLog::warn("借书失败: 借阅人 ", borrowerId, " 图书ID ", bookId, " - ", loanResultMessage(result));
     return result;
 }
 
-std::vector<Book*> Library::findBooksByAuthor(const std::string& author) {
-    std::vector<Book*> result;
-    for (auto& book : books) {
-        if (book.getAuthor() == author) {
-            result.push_back(&book);
+LoanResult Library::checkin(const std::string& borrowerId, int bookId) {
+    std::shared_lock<std::shared_mutex> lock(catalogueMutex);
+    LoanResult result = LoanResult::Ok;
+    auto borrowerIt = borrowerIndexById.find(borrowerId);
+    auto bookIt = bookSlotById.find(bookId);
+    Borrower* borrower = borrowerIt != borrowerIndexById.end() ? borrowers[borrowerIt->second].get() : nullptr;
+    if (!borrower) result = LoanResult::BorrowerNotFound;
+    else if (bookIt == bookSlotById.end()) {
+        std::lock_guard<std::mutex> shard(borrowerMutex(borrowerId));
+        result = borrower->hasBorrowedBook(bookId) ? LoanResult::BookNotFound : LoanResult::NotBorrowed;
+    }
+    else {
+        std::scoped_lock<std::mutex, std::mutex> shards(borrowerMutex(borrowerId), shardOf(bookIt->second).mutex);
+        if (!borrower->hasBorrowedBook(bookId) || !receiveSlot(bookIt->second)) {
+            result = LoanResult::NotBorrowed;
+        } else {
+            borrower->removeBorrowedBookId(bookId);
+            borrower->addToBorrowHistory(bookId, BorrowAction::Return);
+            markBookChanged(bookIt->second, bookId);
+            notify({LibraryChange::Kind::Checkin, bookId, borrowerId, nullptr, borrower});
+            LibraryLog::info("还书成功: ", borrower->getType(), " ", borrower->getName(), " 成功归还《",
+                             books.at(bookIt->second).getTitle(), "》 (", borrower->getCurrentBorrowCount(), "/",
+                             borrower->getMaxBorrowLimit(), ")");
+            return result;
         }
     }
+    LibraryLog::warn("还书失败: 借阅人 ", borrowerId, " 图书ID ", bookId, " - ", loanResultMessage(result));
+    return result;
+}
+
+LoanResult Library::assignOutstandingLoan(const std::string& borrowerId, int bookId) {
+    std::shared_lock<std::shared_mutex> lock(catalogueMutex);
+    auto bookIt = bookSlotById.find(bookId);
+    if (bookIt == bookSlotById.end()) return LoanResult::BookNotFound;
+    auto borrowerIt = borrowerIndexById.find(borrowerId);
+    if (borrowerIt == borrowerIndexById.end()) return LoanResult::BorrowerNotFound;
+    const std::size_t slot = bookIt->second;
+    std::scoped_lock<std::mutex, std::mutex> shards(borrowerMutex(borrowerId), shardOf(slot).mutex);
+    // 先归还一个匿名借出的副本，再借给借阅人；失败时恢复原状。两步在同一组分片锁内完成
+    if (!receiveSlot(slot)) return LoanResult::NotBorrowed;
+    LoanResult result = lendToBorrower(*borrowers[borrowerIt->second], bookId, slot);
+    if (result != LoanResult::Ok) lendSlot(slot);
+    else notify({LibraryChange::Kind::AssignLoan, bookId, borrowerId, nullptr, borrowers[borrowerIt->second].get()});
     return result;
 }
 
 bool Library::lendBook(int bookId) {
-    // 断点1：方法开始
-    Book* book = findBookById(bookId);
-    // 断点2：查找图书后
-    if (book && book->getIsAvailable() && 
-        std::find(borrowedBookIds.begin(), borrowedBookIds.end(), bookId) == borrowedBookIds.end()) {
-        
-        bool success = book->borrowBook();
-        // 断点3：更新图书状态后
-        if (success) {
-            borrowedBookIds.push_back(bookId);
-            availableBooks--;
-            // 错误位置：忘记更新availableBooks计数器
-            std::cout << "图书《" << book->getTitle() << "》借阅成功" << std::endl;
+    std::shared_lock<std::shared_mutex> lock(catalogueMutex);
+    auto it = bookSlotById.find(bookId);
+    if (it != bookSlotById.end()) {
+        std::lock_guard<std::mutex> shard(shardOf(it->second).mutex);
+        if (lendSlot(it->second)) {
+            markBookChanged(it->second, bookId);
+            notify({LibraryChange::Kind::Lend, bookId, {}, nullptr, nullptr});
+            LibraryLog::info("图书《", books.at(it->second).getTitle(), "》借阅成功");
             return true;
         }
     }
-    std::cout << "图书借阅失败" << std::endl;
+    LibraryLog::warn("图书借阅失败");
     return false;
 }
 
 bool Library::receiveBook(int bookId) {
-    Book* book = findBookById(bookId);
-    if (book != nullptr) {
-        auto it = std::find(borrowedBookIds.begin(), borrowedBookIds.end(), bookId);
-        if (it != borrowedBookIds.end()) {
-            if (book->returnBook()) {
-                borrowedBookIds.erase(it);
-                updateStatistics();
-                return true;
-            }
-        }
-    }
-    return false;
+    std::shared_lock<std::shared_mutex> lock(catalogueMutex);
+    auto it = bookSlotById.find(bookId);
+    if (it == bookSlotById.end()) return false;
+    std::lock_guard<std::mutex> shard(shardOf(it->second).mutex);
+    if (!receiveSlot(it->second)) return false;
+    markBookChanged(it->second, bookId);
+    notify({LibraryChange::Kind::Receive, bookId, {}, nullptr, nullptr});
+    return true;
 }
 
 bool Library::isBookAvailable(int bookId) {
@@ -105,6 +344,7 @@ bool Library::isBookAvailable(int bookId) {
 }
 
 void Library::displayAllBooks() const {
+    std::shared_lock<std::shared_mutex> lock(catalogueMutex);
     std::cout << "\n=== " << libraryName << " 所有图书 ===" << std::endl;
     std::cout << "图书馆位置: " << location << std::endl;
     std::cout << "图书总数: " << totalBooks << std::endl;
@@ -122,13 +362,18 @@ void Library::displayAllBooks() const {
 }
 
 void Library::displayAvailableBooks() const {
+    std::shared_lock<std::shared_mutex> lock(catalogueMutex);
     std::cout << "\n=== 可借图书列表 ===" << std::endl;
     int count = 0;
-    for (const auto& book : books) {
-        if (book.getIsAvailable()) {
-            book.displayBookInfo();
-            std::cout << "-_-_-_-_-_-_-_-__" << std::endl;
-            count++;
+    // 先在数值列上筛选，只有命中的图书才访问完整的 Book 对象
+    for (std::size_t chunk = 0; chunk < books.chunkCount(); ++chunk) {
+        const BookStore::CountColumns columns = books.columns(chunk);
+        for (std::size_t i = 0; i < columns.size; ++i) {
+            if (columns.available(i) > 0) {
+                books.at(columns.firstSlot + i).displayBookInfo();
+                std::cout << "-_-_-_-_-_-_-_-__" << std::endl;
+                count++;
+            }
         }
     }
     if (count == 0) {
@@ -137,19 +382,20 @@ void Library::displayAvailableBooks() const {
 }
 
 void Library::displayBorrowedBooks() const {
+    std::shared_lock<std::shared_mutex> lock(catalogueMutex);
     std::cout << "\n-_-_-_-_-_-_-_-__ 已借出图书列表 ==-_-_-_-_-_-_-_-__" << std::endl;
-    if (borrowedBookIds.empty()) {
+    const std::vector<LoanTable::Entry> loans = collectLoans();
+    if (loans.empty()) {
         std::cout << "暂无借出图书" << std::endl;
         return;
     }
     
-    for (int bookId : borrowedBookIds) {
-        const Book* book = const_cast<Library*>(this)->findBookById(bookId);
-        if (book != nullptr) {
-            std::cout << "ID: " << book->getBookId() 
-                      << ", 书名: " << book->getTitle() 
-                      << ", 作者: " << book->getAuthor() << std::endl;
-        }
+    for (const auto& entry : loans) {
+        const Book& book = books.at(entry.slot);
+        std::cout << "ID: " << book.getBookId() 
+                  << ", 书名: " << book.getTitle() 
+                  << ", 作者: " << book.getAuthor()
+                  << ", 借出: " << entry.loans << " 本" << std::endl;
     }
 }
 
@@ -159,7 +405,26 @@ void Library::displayLibraryInfo() const {
     std::cout << "图书馆位置: " << location << std::endl;
     std::cout << "图书总数: " << totalBooks << std::endl;
     std::cout << "可借图书数: " << availableBooks << std::endl;
-    std::cout << "已借出图书数: " << borrowedBookIds.size() << std::endl;
+    std::cout << "已借出图书数: " << getBorrowedCopies() << std::endl;
+}
+
+std::vector<LoanTable::Entry> Library::loanSnapshot() const {
+    std::shared_lock<std::shared_mutex> lock(catalogueMutex);
+    return collectLoans();
+}
+
+// 调用方已持有共享锁；逐个分片加锁复制，结果还原为全局槽位
+std::vector<LoanTable::Entry> Library::collectLoans() const {
+    std::vector<LoanTable::Entry> result;
+    for (std::size_t shard = 0; shard < kLockShards; ++shard) {
+        std::lock_guard<std::mutex> guard(bookShards[shard].mutex);
+        for (const auto& entry : bookShards[shard].loans) {
+            result.push_back(LoanTable::Entry{entry.slot * kLockShards + shard, entry.loans});
+        }
+    }
+    std::sort(result.begin(), result.end(),
+        [](const LoanTable::Entry& a, const LoanTable::Entry& b) { return a.slot < b.slot; });
+    return result;
 }
 
 void Library::displayStatistics() const {
@@ -167,23 +432,28 @@ void Library::displayStatistics() const {
     
     // 按分类统计
     std::cout << "\n按分类统计:" << std::endl;
-    std::vector<std::string> categories;
-    for (const auto& book : books) {
-        std::string category = book.getCategory();
-        if (std::find(categories.begin(), categories.end(), category) == categories.end()) {
-            categories.push_back(category);
-        }
+    for (const auto& row : categoryHistogram()) {
+        std::cout << row.category << ": " << row.titles << " 本"
+                  << " (可借 " << row.availableCopies << " 册, 借出 " << row.borrowedCopies << " 册)" << std::endl;
     }
-    
-    for (const auto& category : categories) {
-        int count = 0;
-        for (const auto& book : books) {
-            if (book.getCategory() == category) {
-                count++;
-            }
-        }
-        std::cout << category << ": " << count << " 本" << std::endl;
+}
+
+std::vector<CategoryStats> Library::categoryHistogram() const {
+    std::shared_lock<std::shared_mutex> lock(catalogueMutex);
+    std::vector<CategoryStats> histogram;
+    histogram.reserve(categoryCounters.size());
+    for (const auto& entry : categoryCounters) {
+        CategoryStats row;
+        row.category = entry.first.str();
+        row.titles = entry.second.titles;
+        row.totalCopies = entry.second.totalCopies;
+        row.availableCopies = entry.second.availableCopies;
+        row.borrowedCopies = row.totalCopies - row.availableCopies;
+        histogram.push_back(std::move(row));
     }
+    std::sort(histogram.begin(), histogram.end(),
+        [](const CategoryStats& a, const CategoryStats& b) { return a.category < b.category; });
+    return histogram;
 }
 
 void Library::initializeWithSampleBooks() {
@@ -224,60 +494,295 @@ void Library::initializeWithSampleBooks() {
 }
 
 void Library::updateStatistics() {
-    totalBooks = books.size();
+    std::unique_lock<std::shared_mutex> lock(catalogueMutex);
+    totalBooks = 0;
     availableBooks = 0;
+    totalCopies = 0;
+    availableCopies = 0;
+    categoryCounters.clear();
+    for (auto it = books.begin(); it != books.end(); ++it) {
+        books.syncCounts(it.slotIndex());
+        accountBook(*it, +1);
+    }
+}
+
+bool Library::verifyStatistics() const {
+    // 独占锁排除进行中的借还，保证读到一致的状态
+    std::unique_lock<std::shared_mutex> lock(catalogueMutex);
+    return statisticsConsistent();
+}
+
+bool Library::statisticsConsistent() const {
+    int titles = 0, available = 0, copies = 0, availableCopyCount = 0;
+    std::unordered_map<Symbol, CategoryCounters, Symbol::Hash> expected;
     for (const auto& book : books) {
-        if (book.getIsAvailable()) {
-            availableBooks++;
+        ++titles;
+        if (book.getIsAvailable()) ++available;
+        copies += book.getTotalCopies();
+        availableCopyCount += book.getAvailableCopies();
+        CategoryCounters& counters = expected[book.getCategorySymbol()];
+        counters.titles++;
+        counters.totalCopies += book.getTotalCopies();
+        counters.availableCopies += book.getAvailableCopies();
+    }
+    if (titles != totalBooks || available != availableBooks ||
+        copies != totalCopies || availableCopyCount != availableCopies ||
+        expected.size() != categoryCounters.size()) {
+        return false;
+    }
+    for (const auto& entry : expected) {
+        auto it = categoryCounters.find(entry.first);
+        if (it == categoryCounters.end() ||
+            it->second.titles != entry.second.titles ||
+            it->second.totalCopies != entry.second.totalCopies ||
+            it->second.availableCopies != entry.second.availableCopies) {
+            return false;
         }
     }
+    return true;
+}
+
+void Library::accountBook(const Book& book, int sign) {
+    totalBooks += sign;
+    if (book.getIsAvailable()) availableBooks += sign;
+    totalCopies += sign * book.getTotalCopies();
+    availableCopies += sign * book.getAvailableCopies();
+
+    Symbol category = book.getCategorySymbol();
+    CategoryCounters& counters = categoryCounters[category];
+    counters.titles += sign;
+    counters.totalCopies += sign * book.getTotalCopies();
+    counters.availableCopies += sign * book.getAvailableCopies();
+    if (counters.titles == 0) {
+        categoryCounters.erase(category);
+    }
+}
+
+void Library::checkStatistics() const {
+#ifdef LIBRARY_VERIFY_STATS
+    assert(statisticsConsistent());
+#endif
 }
 
 void Library::setBooks(const std::vector<Book>& newBooks) {
-    books = newBooks;
-    updateStatistics();
+    std::unique_lock<std::shared_mutex> lock(catalogueMutex);
+    books.clear();
+    bookSlotById.clear();
+    slotsByCategory.clear();
+    slotsByAuthor.clear();
+    indexPositions.clear();
+    titleIndex.clear();
+    for (auto& shard : bookShards) {
+        shard.loans.clear();
+        shard.changedBooks.clear();
+    }
+    removedBookIds.clear();
+    totalBooks = 0;
+    availableBooks = 0;
+    totalCopies = 0;
+    availableCopies = 0;
+    categoryCounters.clear();
+    books.reserve(newBooks.size());
+    bookSlotById.reserve(newBooks.size());
+    indexPositions.reserve(newBooks.size());
+    titleIndex.reserve(newBooks.size());
+    for (const auto& book : newBooks) {
+        if (bookSlotById.count(book.getBookId()) != 0) {
+            LibraryLog::warn("跳过重复的图书ID: ", book.getBookId());
+            continue;
+        }
+        insertBook(book);
+    }
+    checkStatistics();
+}
+
+std::size_t Library::insertBook(const Book& book) {
+    std::size_t slot = books.insert(book);
+    bookSlotById[book.getBookId()] = slot;
+    indexBook(slot);
+    // 载入时已借出的副本也登记为在借，之后可以正常归还
+    shardOf(slot).loans.set(slot / kLockShards, book.getTotalCopies() - book.getAvailableCopies());
+    accountBook(book, +1);
+    return slot;
 }
 
-void Library::setBorrowers(const std::vector<Borrower*>& newBorrowers) {
-    // delete old borrowers
-    for (auto b : borrowers) delete b;
-    borrowers = newBorrowers;
+void Library::indexBook(std::size_t slot) {
+    const Book& book = books.at(slot);
+    if (indexPositions.size() <= slot) indexPositions.resize(slot + 1);
+    auto& categorySlots = slotsByCategory[book.getCategorySymbol()];
+    indexPositions[slot].category = categorySlots.size();
+    categorySlots.push_back(slot);
+    auto& authorSlots = slotsByAuthor[book.getAuthorSymbol()];
+    indexPositions[slot].author = authorSlots.size();
+    authorSlots.push_back(slot);
+    titleIndex.insert(titleHash(book.getTitle()), slot);
 }
 
-// 完成借阅人管理方法的实现
-void Library::addBorrower(Borrower* borrower) {
-    if (findBorrowerById(borrower->getId()) == nullptr) {
-        borrowers.push_back(borrower);
-        std::cout << borrower->getType() << " " << borrower->getName() << "已添加到图书馆系统" << std::endl;
-    } else {
-        std::cout << "添加失败：ID为 " << borrower->getId() << " 的借阅人已存在" << std::endl;
+void Library::unindexBook(std::size_t slot) {
+    const Book& book = books.at(slot);
+    const IndexPosition position = indexPositions[slot];
+    auto category = slotsByCategory.find(book.getCategorySymbol());
+    if (category != slotsByCategory.end()) {
+        indexPositions[eraseSlot(category->second, position.category)].category = position.category;
+        if (category->second.empty()) slotsByCategory.erase(category);
+    }
+    auto author = slotsByAuthor.find(book.getAuthorSymbol());
+    if (author != slotsByAuthor.end()) {
+        indexPositions[eraseSlot(author->second, position.author)].author = position.author;
+        if (author->second.empty()) slotsByAuthor.erase(author);
     }
+    titleIndex.erase(titleHash(book.getTitle()), slot);
 }
 
-void Library::removeBorrower(const std::string& borrowerId) {
-    auto it = std::find_if(borrowers.begin(), borrowers.end(),
-        [&borrowerId](const Borrower* b) { return b->getId() == borrowerId; });
-    
-    if (it != borrowers.end()) {
-        std::cout << (*it)->getType() << " " << (*it)->getName() << "已从系统中移除" << std::endl;
-        delete *it; // 释放内存
-        borrowers.erase(it);
-    } else {
-        std::cout << "未找到ID为 " << borrowerId << " 的借阅人" << std::endl;
+std::vector<Book*> Library::booksAtSlots(const std::vector<std::size_t>* slots) {
+    std::vector<Book*> result;
+    if (!slots) return result;
+    result.reserve(slots->size());
+    for (std::size_t slot : *slots) {
+        result.push_back(&books.at(slot));
     }
+    return result;
+}
+
+void Library::setBorrowers(std::vector<std::unique_ptr<Borrower>> newBorrowers) {
+    std::unique_lock<std::shared_mutex> lock(catalogueMutex);
+    borrowers.clear();
+    borrowerIndexById.clear();
+    changedBorrowerIds.clear();
+    removedBorrowerIds.clear();
+    borrowers.reserve(newBorrowers.size());
+    borrowerIndexById.reserve(newBorrowers.size());
+    for (auto& borrower : newBorrowers) {
+        if (!borrower) continue;
+        if (!insertBorrower(borrower)) {
+            LibraryLog::warn("跳过重复的借阅人ID: ", borrower->getId());
+        }
+    }
+}
+
+// 成功时 borrower 被移入 borrowers；ID 重复时保持不变
+bool Library::insertBorrower(std::unique_ptr<Borrower>& borrower) {
+    auto inserted = borrowerIndexById.emplace(borrower->getId(), borrowers.size());
+    if (!inserted.second) return false;
+    borrowers.push_back(std::move(borrower));
+    return true;
+}
+
+bool Library::addBorrower(std::unique_ptr<Borrower> borrower) {
+    if (!borrower) return false;
+    std::unique_lock<std::shared_mutex> lock(catalogueMutex);
+    if (!insertBorrower(borrower)) {
+        LibraryLog::warn("添加失败：ID为 ", borrower->getId(), " 的借阅人已存在");
+        return false;
+    }
+    const Borrower& added = *borrowers.back();
+    removedBorrowerIds.erase(added.getId());
+    changedBorrowerIds.insert(added.getId());
+    LibraryLog::info(added.getType(), " ", added.getName(), "已添加到图书馆系统");
+    notify({LibraryChange::Kind::AddBorrower, 0, added.getId(), nullptr, &added});
+    return true;
+}
+
+bool Library::removeBorrower(const std::string& borrowerId) {
+    std::unique_lock<std::shared_mutex> lock(catalogueMutex);
+    auto it = borrowerIndexById.find(borrowerId);
+    if (it == borrowerIndexById.end()) {
+        LibraryLog::warn("未找到ID为 ", borrowerId, " 的借阅人");
+        return false;
+    }
+    std::size_t index = it->second;
+    LibraryLog::info(borrowers[index]->getType(), " ", borrowers[index]->getName(), "已从系统中移除");
+    // 先通知：borrowerId 可能引用即将销毁的借阅人自身的 ID
+    notify({LibraryChange::Kind::RemoveBorrower, 0, borrowerId, nullptr, nullptr});
+    changedBorrowerIds.erase(borrowerId);
+    removedBorrowerIds.insert(borrowerId);
+    borrowerIndexById.erase(it);
+    // 与末尾交换后弹出，只需修正被移动者的下标
+    if (index + 1 != borrowers.size()) {
+        borrowers[index] = std::move(borrowers.back());
+        borrowerIndexById[borrowers[index]->getId()] = index;
+    }
+    borrowers.pop_back();
+    return true;
 }
 
 Borrower* Library::findBorrowerById(const std::string& borrowerId) {
-    auto it = std::find_if(borrowers.begin(), borrowers.end(),
-        [&borrowerId](const Borrower* b) { return b->getId() == borrowerId; });
-    
-    return (it != borrowers.end()) ? *it : nullptr;
+    std::shared_lock<std::shared_mutex> lock(catalogueMutex);
+    auto it = borrowerIndexById.find(borrowerId);
+    return (it != borrowerIndexById.end()) ? borrowers[it->second].get() : nullptr;
 }
 
+const Borrower* Library::findBorrowerById(const std::string& borrowerId) const {
+    std::shared_lock<std::shared_mutex> lock(catalogueMutex);
+    auto it = borrowerIndexById.find(borrowerId);
+    return (it != borrowerIndexById.end()) ? borrowers[it->second].get() : nullptr;
+}
+
+void Library::setChangeListener(std::function<void(const LibraryChange&)> listener) {
+    std::unique_lock<std::shared_mutex> lock(catalogueMutex); // 等待进行中的修改完成
+    changeListener = std::move(listener);
+}
 
-Library::~Library() {
-    for (auto borrower : borrowers) {
-        delete borrower;
+LibraryChangeSet Library::takeChanges() {
+    std::unique_lock<std::shared_mutex> lock(catalogueMutex);
+    LibraryChangeSet changes;
+    for (auto& shard : bookShards) {
+        changes.books.insert(changes.books.end(), shard.changedBooks.begin(), shard.changedBooks.end());
+        shard.changedBooks.clear();
+    }
+    changes.removedBooks.assign(removedBookIds.begin(), removedBookIds.end());
+    changes.borrowers.assign(changedBorrowerIds.begin(), changedBorrowerIds.end());
+    changes.removedBorrowers.assign(removedBorrowerIds.begin(), removedBorrowerIds.end());
+    removedBookIds.clear();
+    changedBorrowerIds.clear();
+    removedBorrowerIds.clear();
+    return changes;
+}
+
+void Library::restoreChanges(const LibraryChangeSet& changes) {
+    std::unique_lock<std::shared_mutex> lock(catalogueMutex);
+    for (int bookId : changes.books) {
+        auto it = bookSlotById.find(bookId);
+        if (it != bookSlotById.end()) markBookChanged(it->second, bookId);
+    }
+    for (int bookId : changes.removedBooks) {
+        if (bookSlotById.count(bookId) == 0) removedBookIds.insert(bookId);
+    }
+    for (const auto& borrowerId : changes.borrowers) {
+        if (borrowerIndexById.count(borrowerId) != 0) changedBorrowerIds.insert(borrowerId);
+    }
+    for (const auto& borrowerId : changes.removedBorrowers) {
+        if (borrowerIndexById.count(borrowerId) == 0) removedBorrowerIds.insert(borrowerId);
+    }
+}
+
+void Library::copyChangedRows(const LibraryChangeSet& changes, std::vector<Book>& outBooks,
+                              std::vector<std::unique_ptr<Borrower>>& outBorrowers) const {
+    std::shared_lock<std::shared_mutex> lock(catalogueMutex);
+    outBooks.clear();
+    outBooks.reserve(changes.books.size());
+    for (int bookId : changes.books) {
+        auto it = bookSlotById.find(bookId);
+        if (it != bookSlotById.end()) outBooks.push_back(books.at(it->second));
+    }
+    outBorrowers.clear();
+    for (const auto& borrowerId : changes.borrowers) {
+        auto it = borrowerIndexById.find(borrowerId);
+        if (it == borrowerIndexById.end()) continue;
+        const Borrower& borrower = *borrowers[it->second];
+        switch (borrower.getKind()) {
+            case BorrowerKind::Student:
+                outBorrowers.push_back(std::make_unique<Student>(
+                    borrower.getId(), borrower.getName(), borrower.getDepartment(),
+                    static_cast<const Student&>(borrower).getMajor(), borrower.getMaxBorrowLimit()));
+                break;
+            case BorrowerKind::Teacher:
+                outBorrowers.push_back(std::make_unique<Teacher>(
+                    borrower.getId(), borrower.getName(), borrower.getDepartment(),
+                    static_cast<const Teacher&>(borrower).getTitle(), borrower.getMaxBorrowLimit()));
+                break;
+        }
     }
-    borrowers.clear();
 }
+
+Library::~Library() = default;
@@ -1,22 +1,139 @@
 #ifndef LIBRARY_H
 #define LIBRARY_H
 
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <functional>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <map>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#include <unordered_set>
 #include "Book.h"
+#include "BookStore.h"
+#include "LoanTable.h"
+#include "StringPool.h"
+#include "TitleIndex.h"
 // #include "Borrower.h"
 class Borrower; // 前向声明 
 
+// 单个分类的增量统计。条目只在独占锁下创建/删除，
+// 借还时在共享锁下原子地调整可借册数。
+struct CategoryCounters {
+    std::atomic<int> titles{0};          // 图书种数
+    std::atomic<int> totalCopies{0};     // 总册数
+    std::atomic<int> availableCopies{0}; // 可借册数
+};
+
+// categoryHistogram() 的一行
+struct CategoryStats {
+    std::string category;
+    int titles = 0;
+    int totalCopies = 0;
+    int availableCopies = 0;
+    int borrowedCopies = 0;
+};
+
+// checkout/checkin 的结果
+enum class LoanResult {
+    Ok,
+    BorrowerNotFound,  // 借阅人不存在
+    BookNotFound,      // 图书不存在
+    InvalidDays,       // 借阅天数不合法
+    LimitReached,      // 已达借书上限
+    AlreadyBorrowed,   // 借阅人已借过这本书
+    NoCopiesAvailable, // 暂无可借副本
+    NotBorrowed,       // 借阅人未借这本书（还书时）
+};
+
+// 面向用户的说明文字
+const char* loanResultMessage(LoanResult result);
+
+// 一次成功修改的通知，供日志等增量持久化使用。指针与字符串视图只在回调期间有效
+struct LibraryChange {
+    enum class Kind {
+        AddBook,        // book 为新加入的图书
+        RemoveBook,
+        AddBorrower,    // borrower 为新加入的借阅人
+        RemoveBorrower,
+        Checkout,
+        Checkin,
+        AssignLoan,     // assignOutstandingLoan
+        Lend,           // lendBook（仅日志重放）
+        Receive,        // receiveBook（仅日志重放）
+    };
+    Kind kind;
+    int bookId = 0;
+    std::string_view borrowerId;
+    const Book* book = nullptr;
+    const Borrower* borrower = nullptr;
+};
+
+// 自上次 takeChanges() 以来修改过的图书与借阅人（按 ID 去重），供快照与数据库只写出变化的部分
+struct LibraryChangeSet {
+    std::vector<int> books;                    // 新增或副本数变化、仍在目录中的图书
+    std::vector<int> removedBooks;
+    std::vector<std::string> borrowers;        // 新增的借阅人
+    std::vector<std::string> removedBorrowers;
+
+    bool booksChanged() const { return !books.empty() || !removedBooks.empty(); }
+    bool borrowersChanged() const { return !borrowers.empty() || !removedBorrowers.empty(); }
+    bool empty() const { return !booksChanged() && !borrowersChanged(); }
+};
+
+// 并发：Library 的公开方法可以从多个线程同时调用。
+// 图书/借阅人的增删与整体载入持有目录的独占锁；查询、统计与借还持有共享锁，
+// 借还再只锁定相关图书与借阅人所在的分片，互不相关的借还可以并行。
 class Library {
 private:
+    static constexpr std::size_t kLockShards = 64;
+
+    // 一个图书分片：槽位 slot 属于 slot % kLockShards，
+    // 其在借表以 slot / kLockShards 为键，由同一把锁保护
+    struct alignas(64) BookShard {
+        std::mutex mutex;
+        LoanTable loans;
+        std::unordered_set<int> changedBooks; // 分片内有待写出修改的图书 ID
+    };
+    struct alignas(64) BorrowerShard {
+        std::mutex mutex;
+    };
+    // 槽位在其分类/作者桶中的下标，删除时据此与桶尾交换后弹出
+    struct IndexPosition {
+        std::size_t category = 0;
+        std::size_t author = 0;
+    };
+
     std::string libraryName;     // 图书馆名称
     std::string location;        // 图书馆位置
-        std::vector<Book> books;     // 图书集合 (store by value)
-    std::vector<int> borrowedBookIds; // 已借出图书ID
-    std::vector<Borrower*> borrowers; // 借阅人列表（基类指针）
-    int totalBooks;              // 图书总数
-    int availableBooks;          // 可借图书数
+    BookStore books;             // 图书集合（分块存储，地址稳定）
+    std::unordered_map<int, std::size_t> bookSlotById; // 图书ID -> 存储槽位
+    // 二级索引：分类/作者按驻留字符串分桶，书名按哈希存入开放寻址表（查询时再比较原文）
+    std::unordered_map<Symbol, std::vector<std::size_t>, Symbol::Hash> slotsByCategory;
+    std::unordered_map<Symbol, std::vector<std::size_t>, Symbol::Hash> slotsByAuthor;
+    std::vector<IndexPosition> indexPositions; // 按槽位下标
+    TitleIndex titleIndex;
+    std::vector<std::unique_ptr<Borrower>> borrowers; // 借阅人（由 Library 拥有，对象地址稳定）
+    std::unordered_map<std::string, std::size_t> borrowerIndexById; // 借阅人ID -> borrowers 下标
+    std::atomic<int> totalBooks;          // 图书总数
+    std::atomic<int> availableBooks;      // 可借图书数
+    std::atomic<int> totalCopies{0};      // 总册数
+    std::atomic<int> availableCopies{0};  // 可借册数
+    std::unordered_map<Symbol, CategoryCounters, Symbol::Hash> categoryCounters; // 按分类的统计
+
+    mutable std::shared_mutex catalogueMutex; // 保护图书/借阅人集合与各索引的结构
+    mutable std::array<BookShard, kLockShards> bookShards;         // 图书副本数与在借表
+    mutable std::array<BorrowerShard, kLockShards> borrowerShards; // 借阅人的已借图书与借还历史
+    std::function<void(const LibraryChange&)> changeListener;
+    // 修改记录：借还在分片锁内记入 BookShard::changedBooks，其余只在独占锁下修改
+    std::unordered_set<int> removedBookIds;
+    std::unordered_set<std::string> changedBorrowerIds;
+    std::unordered_set<std::string> removedBorrowerIds;
 
 public: 
     Library();
@@ -24,22 +141,38 @@ public:
     ~Library();
     
     // 图书管理功能
-    void addBook(const Book& book);
+    bool addBook(const Book& book);
+    // 批量添加：整批只取一次独占锁，ID 已存在（或在批内重复）的图书跳过；每本仍各通知一次。返回添加的数目
+    std::size_t addBooks(const std::vector<Book>& newBooks);
     bool removeBook(int bookId);
+    // 原地修改图书信息（可改 ID）：沿用原槽位，在借记录与已有句柄保持不变，可借数按在借副本数重算。
+    // 新 ID 已被占用、总数少于在借副本数、或有在借副本时修改 ID 均拒绝，原图书保持不变
+    bool updateBook(int bookId, const Book& updated);
     Book* findBookById(int bookId);
-    Book* findBookByTitle(const std::string& title);
-    std::vector<Book*> findBooksByCategory(const std::string& category);
-    std::vector<Book*> findBooksByAuthor(const std::string& author);
+    const Book* findBookById(int bookId) const;
+    // 稳定句柄：图书被删除后 resolve 返回 nullptr
+    BookHandle handleOf(int bookId) const;
+    Book* resolve(BookHandle handle);
+    const Book* resolve(BookHandle handle) const;
+    Book* findBookByTitle(std::string_view title);
+    std::vector<Book*> findBooksByCategory(std::string_view category);
+    std::vector<Book*> findBooksByAuthor(std::string_view author);
     
     // 借阅管理功能
-    bool lendBook(int bookId);
-    bool receiveBook(int bookId);
+    static constexpr int kDefaultLoanDays = 7;
+    // 借书/还书的唯一入口：各做一次借阅人与图书查找，全部校验通过后才修改状态。
+    // days 只做校验，到期日由调用方（如数据库借阅记录）保存。
+    LoanResult checkout(const std::string& borrowerId, int bookId, int days = kDefaultLoanDays);
+    LoanResult checkin(const std::string& borrowerId, int bookId);
+    // 把已计入图书在借数、但未归属借阅人的一个副本记到借阅人名下（从数据库恢复借阅时使用）
+    LoanResult assignOutstandingLoan(const std::string& borrowerId, int bookId);
     bool isBookAvailable(int bookId);
     
-    // 借阅人管理
-    void addBorrower(Borrower* borrower);
-    void removeBorrower(const std::string& borrowerId);
+    // 借阅人管理：Library 接管所有权，ID 重复时拒绝并销毁传入对象
+    bool addBorrower(std::unique_ptr<Borrower> borrower);
+    bool removeBorrower(const std::string& borrowerId);
     Borrower* findBorrowerById(const std::string& borrowerId);
+    const Borrower* findBorrowerById(const std::string& borrowerId) const;
     
     // 信息展示功能
     void displayAllBooks() const;
@@ -47,32 +180,95 @@ public:
     void displayBorrowedBooks() const;
     void displayLibraryInfo() const;
     void displayStatistics() const;
+    // 按分类汇总（直接读取增量维护的计数，按分类名排序）
+    std::vector<CategoryStats> categoryHistogram() const;
     
     // 初始化功能
     void initializeWithSampleBooks();
     
     // 工具方法
+    // 统计量随每次增删/借还增量维护；仅当绕过 Library 直接修改 Book 后才需要调用此方法全量重算
     void updateStatistics();
+    // 与全量重算结果比对，用于调试；定义 LIBRARY_VERIFY_STATS 时每次修改后自动断言
+    bool verifyStatistics() const;
     
     // 获取器
     std::string getLibraryName() const { return libraryName; }
     std::string getLocation() const { return location; }
     int getTotalBooks() const { return totalBooks; }
     int getAvailableBooks() const { return availableBooks; }
+    int getTotalCopies() const { return totalCopies; }
+    int getAvailableCopies() const { return availableCopies; }
+    int getBorrowedCopies() const { return totalCopies - availableCopies; }
+    // 在借图书快照：每项为槽位与在借副本数（按槽位排序），可用 getBooks().at(entry.slot) 取图书
+    std::vector<LoanTable::Entry> loanSnapshot() const;
     
+    // 遍历 getBooks()/getBorrowers() 期间持有此锁，可防止其他线程增删图书或借阅人；
+    // 持有期间不要在同一线程调用会加锁的 Library 方法
+    std::shared_lock<std::shared_mutex> readLock() const { return std::shared_lock<std::shared_mutex>(catalogueMutex); }
+    // 独占锁：持有期间借还也会等待，用于写出与某一时刻完全一致的快照；限制同 readLock
+    std::unique_lock<std::shared_mutex> writeLock() const { return std::unique_lock<std::shared_mutex>(catalogueMutex); }
+
+    // 每次成功的增删与借还之后调用一次（传空函数取消）。回调在 Library 的锁内执行，
+    // 可能来自多个线程并发调用，须自行同步且不能回调 Library；
+    // setBooks/setBorrowers 的整体载入不通知
+    void setChangeListener(std::function<void(const LibraryChange&)> listener);
+
+    // 取出并清空修改记录。setBooks/setBorrowers 视载入的内容为已持久化的基线，清空对应的记录；
+    // assignOutstandingLoan 不改变副本数，不计为修改。不能在持有 readLock/writeLock 时调用
+    LibraryChangeSet takeChanges();
+    // 写出失败时放回取出的记录，下次保存时重试；其间已被删除或重新加入的条目以当前状态为准
+    void restoreChanges(const LibraryChangeSet& changes);
+    // 在共享锁下复制修改记录中仍在目录里的图书与借阅人（借阅人只复制身份字段）。
+    // 写出副本时不必持锁，也不会因其他线程并发删除而访问已释放的对象
+    void copyChangedRows(const LibraryChangeSet& changes, std::vector<Book>& outBooks,
+                         std::vector<std::unique_ptr<Borrower>>& outBorrowers) const;
+
     // expose collections for saving/loading
-    const std::vector<Book>& getBooks() const { return books; }
-    // non-const access so callers (e.g. GUI controller) can obtain stable pointers to internal Book objects
-    std::vector<Book>& getBooks() { return books; }
-    const std::vector<Borrower*>& getBorrowers() const { return borrowers; }
+    const BookStore& getBooks() const { return books; }
+    // non-const access so callers (e.g. GUI controller) can obtain stable pointers to internal Book objects;
+    // BookStore 的增删接口仅对 Library 开放，外部只能遍历和修改已有图书
+    BookStore& getBooks() { return books; }
+    // 删除借阅人时与末尾交换，遍历顺序不保证为插入顺序
+    const std::vector<std::unique_ptr<Borrower>>& getBorrowers() const { return borrowers; }
     
     // setters for loading
     void setBooks(const std::vector<Book>& newBooks);
-    void setBorrowers(const std::vector<Borrower*>& newBorrowers);
+    void setBorrowers(std::vector<std::unique_ptr<Borrower>> newBorrowers);
     
     // 设置器
     void setLibraryName(const std::string& name) { libraryName = name; }
     void setLocation(const std::string& loc) { location = loc; }
+
+private:
+    // 日志重放需要 lendBook/receiveBook 还原旧日志中不关联借阅人的借还，其余调用方只能经 checkout/checkin
+    friend class LibraryJournal;
+
+    // 不关联借阅人的借出/归还，仅调整副本数，绕过借书上限等校验
+    bool lendBook(int bookId);
+    bool receiveBook(int bookId);
+
+    std::size_t insertBook(const Book& book);
+    // 以下借还辅助函数要求调用方已持有共享锁及相关分片锁
+    BookShard& shardOf(std::size_t slot) const { return bookShards[slot % kLockShards]; }
+    std::mutex& borrowerMutex(const std::string& borrowerId) const;
+    bool lendSlot(std::size_t slot);
+    bool receiveSlot(std::size_t slot);
+    LoanResult lendToBorrower(Borrower& borrower, int bookId, std::size_t slot);
+    void accountLoan(const Book& book, int copyDelta, bool wasAvailable);
+    bool insertBorrower(std::unique_ptr<Borrower>& borrower);
+    void indexBook(std::size_t slot);
+    void unindexBook(std::size_t slot);
+    void accountBook(const Book& book, int sign);
+    bool statisticsConsistent() const;
+    void checkStatistics() const;
+    std::vector<LoanTable::Entry> collectLoans() const;
+    std::vector<Book*> booksAtSlots(const std::vector<std::size_t>* slots);
+    // 要求调用方已持有独占锁，或共享锁及该槽位所在分片的锁
+    void markBookChanged(std::size_t slot, int bookId) { shardOf(slot).changedBooks.insert(bookId); }
+    void notify(const LibraryChange& change) const {
+        if (changeListener) changeListener(change);
+    }
 };
 
 #endif // LIBRARY_H
\ No newline at end of file
@@ -0,0 +1,407 @@
+#include "LibraryJournal.h"
+#include "FileManager.h"
+#include "Library.h"
+#include "MappedFile.h"
+#include "TsvFormat.h"
+
+#include <charconv>
+#include <filesystem>
+#include <iostream>
+#include <sstream>
+#include <string_view>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <unistd.h>
+#define LIBRARYJOURNAL_HAS_FSYNC 1
+#endif
+
+namespace {
+
+// 日志格式：首行为日志头，之后每行一条记录，首字段为记录类型：
+//   B <图书行>      添加图书（与 books.tsv 的一行相同）   b <图书ID>          删除图书
+//   U <借阅人行>    添加借阅人（与 users.tsv 的一行相同） u <借阅人ID>        删除借阅人
+//   C/R/A <借阅人ID> <图书ID>  借书 / 还书 / 归属匿名借出   L/l <图书ID>  匿名借出 / 归还
+constexpr std::string_view kMagic = "LMSJOURNAL";
+constexpr int kVersion = 1;
+
+// 快照文件的标识：大小与修改时间，文件不存在时全为零
+struct FileStamp {
+    std::uint64_t size = 0;
+    std::int64_t mtime = 0;
+    bool operator==(const FileStamp& other) const { return size == other.size && mtime == other.mtime; }
+};
+
+FileStamp stampOf(const std::string& filename) {
+    FileStamp stamp;
+    std::error_code ec;
+    const auto size = std::filesystem::file_size(filename, ec);
+    if (ec) return stamp;
+    const auto time = std::filesystem::last_write_time(filename, ec);
+    if (ec) return stamp;
+    stamp.size = size;
+    stamp.mtime = static_cast<std::int64_t>(time.time_since_epoch().count());
+    return stamp;
+}
+
+std::string formatHeader(const FileStamp& books, const FileStamp& users) {
+    std::ostringstream out;
+    out << kMagic << '\t' << kVersion << '\t' << books.size << '\t' << books.mtime << '\t'
+        << users.size << '\t' << users.mtime << '\n';
+    return out.str();
+}
+
+template <typename T>
+bool parseNumber(std::string_view text, T& value) {
+    const char* end = text.data() + text.size();
+    auto result = std::from_chars(text.data(), end, value);
+    return result.ec == std::errc() && result.ptr == end && !text.empty();
+}
+
+bool parseHeader(std::string_view line, FileStamp& books, FileStamp& users) {
+    std::string_view fields[6];
+    int version = 0;
+    return tsv::split(line, fields, 6) == 6 && fields[0] == kMagic &&
+           parseNumber(fields[1], version) && version == kVersion &&
+           parseNumber(fields[2], books.size) && parseNumber(fields[3], books.mtime) &&
+           parseNumber(fields[4], users.size) && parseNumber(fields[5], users.mtime);
+}
+
+// 把已写入 FILE 的数据刷到磁盘
+bool syncFile(std::FILE* file) {
+    if (std::fflush(file) != 0) return false;
+#ifdef LIBRARYJOURNAL_HAS_FSYNC
+    return ::fsync(::fileno(file)) == 0;
+#else
+    return true;
+#endif
+}
+
+// 快照文件由 writeFileSafely 写出，只保证替换是原子的；清空日志前还需确认内容已落盘
+bool syncPath(const std::string& filename) {
+#ifdef LIBRARYJOURNAL_HAS_FSYNC
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    bool ok = ::fsync(fd) == 0;
+    ::close(fd);
+    return ok;
+#else
+    (void)filename;
+    return true;
+#endif
+}
+
+void appendBookId(std::string& line, char tag, int bookId) {
+    line += tag;
+    line += '\t';
+    tsv::appendInt(line, bookId);
+}
+
+void appendLoan(std::string& line, char tag, const LibraryChange& change) {
+    line += tag;
+    line += '\t';
+    tsv::appendEscaped(line, change.borrowerId);
+    line += '\t';
+    tsv::appendInt(line, change.bookId);
+}
+
+std::string encodeChange(const LibraryChange& change) {
+    std::string line;
+    switch (change.kind) {
+        case LibraryChange::Kind::AddBook:
+            line = "B\t";
+            tsv::appendBook(line, *change.book);
+            break;
+        case LibraryChange::Kind::AddBorrower:
+            line = "U\t";
+            tsv::appendBorrower(line, *change.borrower);
+            break;
+        case LibraryChange::Kind::RemoveBook: appendBookId(line, 'b', change.bookId); break;
+        case LibraryChange::Kind::RemoveBorrower:
+            line = "u\t";
+            tsv::appendEscaped(line, change.borrowerId);
+            break;
+        case LibraryChange::Kind::Checkout: appendLoan(line, 'C', change); break;
+        case LibraryChange::Kind::Checkin: appendLoan(line, 'R', change); break;
+        case LibraryChange::Kind::AssignLoan: appendLoan(line, 'A', change); break;
+        case LibraryChange::Kind::Lend: appendBookId(line, 'L', change.bookId); break;
+        case LibraryChange::Kind::Receive: appendBookId(line, 'l', change.bookId); break;
+    }
+    line += '\n';
+    return line;
+}
+
+} // namespace
+
+// 只重放所依据的快照文件未被重写的记录：借还与图书增删依赖 books.tsv，借阅人增删依赖 users.tsv。
+// 借阅人名下的借阅不在 TSV 快照中，借阅人无法借/还时退回为只调整副本数，保证副本数与记录时一致。
+LibraryJournal::ReplayOutcome LibraryJournal::replayRecord(Library& library, std::string_view line,
+                                                          bool booksMatch, bool usersMatch) {
+    if (line.size() < 2 || line[1] != '\t') return ReplayOutcome::Invalid;
+    const char tag = line[0];
+    const std::string_view body = line.substr(2);
+    const bool needsUsers = tag == 'U' || tag == 'u';
+    if (needsUsers ? !usersMatch : !booksMatch) return ReplayOutcome::Skipped;
+
+    int bookId = 0;
+    switch (tag) {
+        case 'B': {
+            const char* error = nullptr;
+            auto book = tsv::parseBook(body, error);
+            if (!book) return ReplayOutcome::Invalid;
+            library.addBook(*book);
+            return ReplayOutcome::Applied;
+        }
+        case 'U': {
+            auto borrower = tsv::parseBorrower(body);
+            if (!borrower) return ReplayOutcome::Invalid;
+            library.addBorrower(std::move(borrower));
+            return ReplayOutcome::Applied;
+        }
+        case 'u':
+            library.removeBorrower(tsv::unescape(body));
+            return ReplayOutcome::Applied;
+        case 'b':
+        case 'L':
+        case 'l':
+            if (!tsv::parseInt(body, bookId)) return ReplayOutcome::Invalid;
+            if (tag == 'b') library.removeBook(bookId);
+            else if (tag == 'L') library.lendBook(bookId);
+            else library.receiveBook(bookId);
+            return ReplayOutcome::Applied;
+        case 'C':
+        case 'R':
+        case 'A': {
+            std::string_view fields[2];
+            if (tsv::split(body, fields, 2) != 2 || !tsv::parseInt(fields[1], bookId)) return ReplayOutcome::Invalid;
+            const std::string borrowerId = tsv::unescape(fields[0]);
+            if (tag == 'C' && library.checkout(borrowerId, bookId) != LoanResult::Ok) library.lendBook(bookId);
+            else if (tag == 'R' && library.checkin(borrowerId, bookId) != LoanResult::Ok) library.receiveBook(bookId);
+            else if (tag == 'A') library.assignOutstandingLoan(borrowerId, bookId);
+            return ReplayOutcome::Applied;
+        }
+    }
+    return ReplayOutcome::Invalid;
+}
+
+LibraryJournal::LibraryJournal(Library& library, std::string journalFile, std::string booksFile, std::string usersFile)
+    : LibraryJournal(library, std::move(journalFile), std::move(booksFile), std::move(usersFile), Options()) {}
+
+LibraryJournal::LibraryJournal(Library& library, std::string journalFile, std::string booksFile, std::string usersFile,
+                               Options options)
+    : library(library), journalFile(std::move(journalFile)), booksFile(std::move(booksFile)),
+      usersFile(std::move(usersFile)), options(options) {}
+
+LibraryJournal::~LibraryJournal() {
+    stop();
+}
+
+bool LibraryJournal::start() {
+    if (running) return true;
+
+    // 只有日志头与当前快照一致、且末尾没有写了一半的记录时，才能继续追加
+    bool reusable = false;
+    {
+        MappedFile existing(journalFile);
+        const std::string_view text = existing.contents();
+        FileStamp books, users;
+        reusable = existing.isOpen() && !text.empty() && text.back() == '\n' &&
+                   parseHeader(text.substr(0, text.find('\n')), books, users) &&
+                   books == stampOf(booksFile) && users == stampOf(usersFile);
+        if (reusable) bytes = text.size();
+        // 继续追加时，只有日志里已有记录的快照才与内存不一致（保守地按两侧都有修改处理）
+        const bool pending = !reusable || text.find('\n') + 1 < text.size();
+        booksDirty = pending;
+        usersDirty = pending;
+    }
+    {
+        std::lock_guard<std::mutex> io(ioMutex);
+        if (reusable) {
+            file = std::fopen(journalFile.c_str(), "ab");
+            reusable = file != nullptr;
+        }
+    }
+
+    library.setChangeListener([this](const LibraryChange& change) { record(change); });
+    if (!reusable && !compact()) {
+        library.setChangeListener(nullptr);
+        std::lock_guard<std::mutex> io(ioMutex);
+        if (file) std::fclose(file);
+        file = nullptr;
+        buffer.clear();
+        return false;
+    }
+
+    stopping = false;
+    running = true;
+    worker = std::thread(&LibraryJournal::run, this);
+    return true;
+}
+
+void LibraryJournal::stop() {
+    if (!running) return;
+    library.setChangeListener(nullptr); // 等待进行中的修改完成，之后不再有新记录
+    {
+        std::lock_guard<std::mutex> lock(bufferMutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    worker.join();
+
+    std::lock_guard<std::mutex> io(ioMutex);
+    writePending();
+    if (file) std::fclose(file);
+    file = nullptr;
+    running = false;
+}
+
+void LibraryJournal::record(const LibraryChange& change) {
+    const std::string line = encodeChange(change); // 在缓冲锁外编码
+    switch (change.kind) {
+        case LibraryChange::Kind::AddBorrower:
+        case LibraryChange::Kind::RemoveBorrower: usersDirty = true; break;
+        case LibraryChange::Kind::AssignLoan: break; // 副本数不变
+        default: booksDirty = true; break;
+    }
+    std::lock_guard<std::mutex> lock(bufferMutex);
+    buffer += line;
+    if (buffer.size() >= options.batchBytes) wake.notify_one();
+}
+
+// 后台线程：按间隔或缓冲大小批量写出并 fsync，日志过大时压缩
+void LibraryJournal::run() {
+    std::uint64_t compactAt = options.compactBytes;
+    std::unique_lock<std::mutex> lock(bufferMutex);
+    while (!stopping) {
+        wake.wait_for(lock, options.syncInterval,
+                      [this] { return stopping || buffer.size() >= options.batchBytes; });
+        lock.unlock();
+        sync();
+        if (bytes.load() >= compactAt) {
+            // 压缩失败（如磁盘已满）时继续追加，日志再增长一个阈值后重试
+            compactAt = compact() ? options.compactBytes : bytes.load() + options.compactBytes;
+        }
+        lock.lock();
+    }
+}
+
+bool LibraryJournal::sync() {
+    std::lock_guard<std::mutex> io(ioMutex);
+    return writePending();
+}
+
+bool LibraryJournal::checkpoint() {
+    if (!running) return false;
+    return compact();
+}
+
+bool LibraryJournal::compact() {
+    auto exclusive = library.writeLock(); // 快照与新日志的分界点上没有进行中的修改
+    std::lock_guard<std::mutex> io(ioMutex);
+    // 只重写自上次压缩以来有修改的快照文件；未修改的文件保持原样，新日志头照常记下它的标识
+    std::error_code ec;
+    const bool writeBooks = booksDirty || !std::filesystem::exists(booksFile, ec);
+    const bool writeUsers = usersDirty || !std::filesystem::exists(usersFile, ec);
+    const bool saved =
+        (!writeBooks || (FileManager::saveBooksToFile(library.getBooks(), booksFile) && syncPath(booksFile))) &&
+        (!writeUsers || (FileManager::saveBorrowersToFile(library.getBorrowers(), usersFile) && syncPath(usersFile)));
+    if (!saved) {
+        std::cerr << "日志压缩失败：无法写出快照，继续追加到 " << journalFile << std::endl;
+        if (file) writePending();
+        return false;
+    }
+    {
+        // 缓冲中的记录都发生在取得独占锁之前，已包含在快照中
+        std::lock_guard<std::mutex> lock(bufferMutex);
+        buffer.clear();
+    }
+    booksDirty = false;
+    usersDirty = false;
+    if (!resetJournal()) return false;
+    compactions++;
+    return true;
+}
+
+bool LibraryJournal::writePending() {
+    spare.clear();
+    {
+        std::lock_guard<std::mutex> lock(bufferMutex);
+        buffer.swap(spare);
+    }
+    if (spare.empty()) return true;
+    if (!file) {
+        std::cerr << "日志未打开，" << spare.size() << " 字节的记录未写出: " << journalFile << std::endl;
+        return false;
+    }
+    const std::size_t written = std::fwrite(spare.data(), 1, spare.size(), file);
+    bytes += written;
+    if (written != spare.size() || !syncFile(file)) {
+        std::cerr << "写入日志失败: " << journalFile << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool LibraryJournal::resetJournal() {
+    if (file) std::fclose(file);
+    file = nullptr;
+
+    // 先写临时文件再替换，崩溃时要么是旧日志（与新快照不匹配，不会重放），要么是新的空日志
+    const std::string header = formatHeader(stampOf(booksFile), stampOf(usersFile));
+    const std::string tempFile = journalFile + ".tmp";
+    std::FILE* out = std::fopen(tempFile.c_str(), "wb");
+    bool ok = out != nullptr && std::fwrite(header.data(), 1, header.size(), out) == header.size() && syncFile(out);
+    if (out) std::fclose(out);
+    std::error_code ec;
+    if (ok) std::filesystem::rename(tempFile, journalFile, ec);
+    if (!ok || ec) {
+        std::cerr << "无法新建日志: " << journalFile << std::endl;
+        std::filesystem::remove(tempFile, ec);
+        return false;
+    }
+
+    file = std::fopen(journalFile.c_str(), "ab");
+    if (!file) {
+        std::cerr << "无法打开日志用于追加: " << journalFile << std::endl;
+        return false;
+    }
+    bytes = header.size();
+    return true;
+}
+
+std::size_t LibraryJournal::replay(Library& library, const std::string& journalFile,
+                                   const std::string& booksFile, const std::string& usersFile) {
+    MappedFile input(journalFile);
+    if (!input.isOpen()) return 0;
+    const std::string_view text = input.contents();
+    const std::size_t headerEnd = text.find('\n');
+    FileStamp books, users;
+    if (headerEnd == std::string_view::npos || !parseHeader(text.substr(0, headerEnd), books, users)) {
+        std::cerr << "日志头无效，已忽略: " << journalFile << std::endl;
+        return 0;
+    }
+    const bool booksMatch = books == stampOf(booksFile);
+    const bool usersMatch = users == stampOf(usersFile);
+    if (!booksMatch && !usersMatch) {
+        std::cout << "日志中的记录已包含在快照中，无需重放: " << journalFile << std::endl;
+        return 0;
+    }
+
+    std::size_t applied = 0, invalid = 0;
+    for (std::size_t pos = headerEnd + 1; pos < text.size();) {
+        const std::size_t end = text.find('\n', pos);
+        if (end == std::string_view::npos) {
+            std::cerr << journalFile << ": 末尾不完整的记录已忽略" << std::endl; // 写入时崩溃
+            break;
+        }
+        switch (replayRecord(library, text.substr(pos, end - pos), booksMatch, usersMatch)) {
+            case ReplayOutcome::Applied: ++applied; break;
+            case ReplayOutcome::Invalid: ++invalid; break;
+            case ReplayOutcome::Skipped: break;
+        }
+        pos = end + 1;
+    }
+    if (invalid > 0) std::cerr << journalFile << ": 跳过 " << invalid << " 条非法记录" << std::endl;
+    std::cout << "Replayed " << applied << " journal records from " << journalFile << std::endl;
+    return applied;
+}
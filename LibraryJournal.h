@@ -0,0 +1,94 @@
+#ifndef LIBRARYJOURNAL_H
+#define LIBRARYJOURNAL_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+
+class Library;
+struct LibraryChange;
+
+// 文件模式的追加日志：每次借还与目录增删追加一行记录，一次借还不再需要重写
+// books.tsv / users.tsv。记录先进入内存缓冲，由后台线程成批写出并 fsync；
+// 日志超过阈值后，后台线程写出新快照并清空日志（压缩），只重写有修改的快照文件。
+//
+// 日志头记下它所基于的快照文件（大小与修改时间），载入时只重放与当前快照匹配的部分，
+// 因此快照被其他途径重写过、或压缩在写完快照后中断时，已包含在快照里的记录不会重复生效。
+// 持久性：记录在下一次批量 fsync 之后才落盘，崩溃时可能丢失最后一批（至多 syncInterval）。
+class LibraryJournal {
+public:
+    struct Options {
+        std::size_t compactBytes = 8u << 20;          // 日志超过此大小后压缩为新快照
+        std::size_t batchBytes = 64u << 10;           // 缓冲超过此大小立即写出
+        std::chrono::milliseconds syncInterval{50};   // 两次 fsync 的最长间隔
+    };
+
+    LibraryJournal(Library& library, std::string journalFile, std::string booksFile, std::string usersFile);
+    LibraryJournal(Library& library, std::string journalFile, std::string booksFile, std::string usersFile,
+                   Options options);
+    ~LibraryJournal(); // 未停止时先 stop()
+    LibraryJournal(const LibraryJournal&) = delete;
+    LibraryJournal& operator=(const LibraryJournal&) = delete;
+
+    // 开始记录 library 的修改（应在载入快照并重放日志之后调用）。
+    // 现有日志与当前快照不匹配或不存在时，先写出新快照并新建日志
+    bool start();
+    // 写出剩余记录，停止记录与后台线程
+    void stop();
+    bool isRunning() const { return running; }
+
+    // 立即写出并 fsync 已缓冲的记录
+    bool sync();
+    // 写出新快照并清空日志；期间 Library 的所有修改都会等待。仅在 start() 之后有效
+    bool checkpoint();
+
+    std::uint64_t journalBytes() const { return bytes.load(); }
+    std::size_t compactionCount() const { return compactions.load(); }
+
+    // 把日志中与当前快照匹配的记录重放到 library，在载入快照之后、start() 之前调用。
+    // 返回重放的记录数；日志不存在、损坏或早于快照时返回 0
+    static std::size_t replay(Library& library, const std::string& journalFile,
+                              const std::string& booksFile, const std::string& usersFile);
+
+private:
+    enum class ReplayOutcome { Applied, Skipped, Invalid };
+    // 重放一条记录；借阅人无法借/还时要用到 Library 只对日志开放的 lendBook/receiveBook
+    static ReplayOutcome replayRecord(Library& library, std::string_view line, bool booksMatch, bool usersMatch);
+
+    Library& library;
+    std::string journalFile;
+    std::string booksFile;
+    std::string usersFile;
+    Options options;
+    bool running = false;
+
+    std::mutex bufferMutex;          // 保护 buffer 与 stopping
+    std::condition_variable wake;
+    std::string buffer;              // 尚未写出的记录
+    bool stopping = false;
+
+    std::mutex ioMutex;              // 保护 file 与 spare，写出/压缩时持有
+    std::FILE* file = nullptr;
+    std::string spare;               // 与 buffer 交换后写出，避免持有 bufferMutex 做 I/O
+    std::atomic<std::uint64_t> bytes{0};
+    std::atomic<std::size_t> compactions{0};
+    // 自上次压缩以来 books.tsv / users.tsv 是否有修改；压缩时跳过未修改的文件
+    std::atomic<bool> booksDirty{true};
+    std::atomic<bool> usersDirty{true};
+    std::thread worker;
+
+    void record(const LibraryChange& change);
+    void run();
+    bool compact();        // checkpoint() 的实现，后台线程直接调用
+    bool writePending();   // 需持有 ioMutex
+    bool resetJournal();   // 需持有 ioMutex：以当前快照为基础新建空日志
+};
+
+#endif // LIBRARYJOURNAL_H
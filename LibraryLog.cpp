@@ -0,0 +1,26 @@
+#include "LibraryLog.h"
+
+#include <iostream>
+
+namespace {
+
+LibraryLog::Sink& currentSink() {
+    static LibraryLog::Sink sink;
+    return sink;
+}
+
+} // namespace
+
+void LibraryLog::setSink(Sink sink, LogLevel minLevel) {
+    currentSink() = std::move(sink);
+    threshold.store(currentSink() ? static_cast<int>(minLevel) : static_cast<int>(LogLevel::Off),
+                    std::memory_order_relaxed);
+}
+
+LibraryLog::Sink LibraryLog::consoleSink() {
+    return [](LogLevel, const std::string& message) { std::cout << message << '\n'; };
+}
+
+void LibraryLog::dispatch(LogLevel level, const std::string& message) {
+    if (currentSink()) currentSink()(level, message);
+}
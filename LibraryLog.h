@@ -0,0 +1,44 @@
+#ifndef LIBRARYLOG_H
+#define LIBRARYLOG_H
+
+#include <atomic>
+#include <functional>
+#include <sstream>
+#include <string>
+
+enum class LogLevel { Debug = 0, Info, Warning, Error, Off };
+
+// Library/Borrower 的事件消息出口。默认丢弃所有消息（不格式化、不做 I/O），
+// 需要输出的前端（如 CLI）在启动时安装自己的 sink。
+class LibraryLog {
+public:
+    using Sink = std::function<void(LogLevel level, const std::string& message)>;
+
+    // 应在启动时调用，不与日志写入并发
+    static void setSink(Sink sink, LogLevel minLevel = LogLevel::Info);
+    static void reset() { setSink(nullptr, LogLevel::Off); }
+    // 逐行写到 std::cout，不强制刷新
+    static Sink consoleSink();
+
+    static bool enabled(LogLevel level) {
+        return static_cast<int>(level) >= threshold.load(std::memory_order_relaxed);
+    }
+
+    // 参数依次写入消息；级别未开启时直接返回，不构造字符串
+    template <typename... Args>
+    static void write(LogLevel level, const Args&... args) {
+        if (!enabled(level)) return;
+        std::ostringstream out;
+        (out << ... << args);
+        dispatch(level, out.str());
+    }
+    template <typename... Args> static void debug(const Args&... args) { write(LogLevel::Debug, args...); }
+    template <typename... Args> static void info(const Args&... args) { write(LogLevel::Info, args...); }
+    template <typename... Args> static void warn(const Args&... args) { write(LogLevel::Warning, args...); }
+
+private:
+    static inline std::atomic<int> threshold{static_cast<int>(LogLevel::Off)};
+    static void dispatch(LogLevel level, const std::string& message);
+};
+
+#endif // LIBRARYLOG_H
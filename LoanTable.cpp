@@ -0,0 +1,52 @@
+#include "LoanTable.h"
+
+void LoanTable::add(std::size_t slot) {
+    set(slot, loansFor(slot) + 1);
+}
+
+bool LoanTable::remove(std::size_t slot) {
+    int current = loansFor(slot);
+    if (current <= 0) return false;
+    set(slot, current - 1);
+    return true;
+}
+
+void LoanTable::set(std::size_t slot, int loans) {
+    if (slot >= positionOf.size()) {
+        if (loans <= 0) return;
+        positionOf.resize(slot + 1, npos);
+    }
+
+    std::size_t pos = positionOf[slot];
+    if (pos == npos) {
+        if (loans <= 0) return;
+        positionOf[slot] = dense.size();
+        dense.push_back({slot, loans});
+        outstanding += loans;
+        return;
+    }
+
+    outstanding += loans - dense[pos].loans;
+    if (loans > 0) {
+        dense[pos].loans = loans;
+        return;
+    }
+
+    // 与末尾交换后弹出，保持 O(1)
+    const Entry last = dense.back();
+    dense[pos] = last;
+    positionOf[last.slot] = pos;
+    dense.pop_back();
+    positionOf[slot] = npos;
+}
+
+void LoanTable::clear() {
+    dense.clear();
+    positionOf.clear();
+    outstanding = 0;
+}
+
+int LoanTable::loansFor(std::size_t slot) const {
+    if (slot >= positionOf.size() || positionOf[slot] == npos) return 0;
+    return dense[positionOf[slot]].loans;
+}
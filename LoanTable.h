@@ -0,0 +1,41 @@
+#ifndef LOANTABLE_H
+#define LOANTABLE_H
+
+#include <cstddef>
+#include <vector>
+
+// 在借图书表：以 BookStore 槽位为键的稀疏集合。
+// dense 只保存当前有在借副本的图书，登记/归还/删除都是 O(1)，
+// 遍历只访问在借图书；同一本书借出多个副本时累计计数。
+class LoanTable {
+public:
+    struct Entry {
+        std::size_t slot; // 图书在 BookStore 中的槽位
+        int loans;        // 在借副本数
+    };
+
+    using const_iterator = std::vector<Entry>::const_iterator;
+
+    void add(std::size_t slot);
+    bool remove(std::size_t slot);
+    void set(std::size_t slot, int loans);
+    void clearSlot(std::size_t slot) { set(slot, 0); }
+    void clear();
+
+    int loansFor(std::size_t slot) const;
+    std::size_t titleCount() const { return dense.size(); }
+    int totalLoans() const { return outstanding; }
+    bool empty() const { return dense.empty(); }
+
+    const_iterator begin() const { return dense.begin(); }
+    const_iterator end() const { return dense.end(); }
+
+private:
+    static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+    std::vector<Entry> dense;
+    std::vector<std::size_t> positionOf; // 槽位 -> dense 下标
+    int outstanding = 0;
+};
+
+#endif // LOANTABLE_H
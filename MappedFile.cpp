@@ -0,0 +1,47 @@
+#include "MappedFile.h"
+
+#include <fstream>
+#include <iterator>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define MAPPEDFILE_HAS_MMAP 1
+#endif
+
+MappedFile::MappedFile(const std::string& filename) {
+#ifdef MAPPEDFILE_HAS_MMAP
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) return;
+    struct stat info;
+    if (::fstat(fd, &info) == 0) {
+        opened = true;
+        size = static_cast<std::size_t>(info.st_size);
+        if (size > 0) {
+            void* region = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (region != MAP_FAILED) {
+                ::madvise(region, size, MADV_SEQUENTIAL); // 顺序扫描，提示内核预读
+                data = static_cast<const char*>(region);
+                mapped = true;
+            }
+        }
+    }
+    ::close(fd);
+    if (!opened || mapped || size == 0) return;
+    opened = false; // 映射失败，改为读入内存
+#endif
+    std::ifstream stream(filename, std::ios::binary);
+    if (!stream.is_open()) return;
+    fallback.assign(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+    data = fallback.data();
+    size = fallback.size();
+    opened = true;
+}
+
+MappedFile::~MappedFile() {
+#ifdef MAPPEDFILE_HAS_MMAP
+    if (mapped) ::munmap(const_cast<char*>(data), size);
+#endif
+}
@@ -0,0 +1,29 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// 只读映射整个文件，内容以 string_view 暴露，析构时解除映射。
+// 不支持 mmap 的平台或映射失败时，退回为一次性读入内存。
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& filename);
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool isOpen() const { return opened; }
+    // 文件内容；对象存活期间有效
+    std::string_view contents() const { return std::string_view(data, size); }
+
+private:
+    const char* data = nullptr;
+    std::size_t size = 0;
+    bool opened = false;
+    bool mapped = false;  // true 时 data 指向映射区，需要 munmap
+    std::string fallback; // 未映射时保存读入的内容
+};
+
+#endif // MAPPEDFILE_H
@@ -0,0 +1,62 @@
+#include "SmallIntSet.h"
+
+std::size_t SmallIntSet::inlineIndexOf(int value) const {
+    for (std::size_t i = 0; i < count; ++i) {
+        if (inlineValues[i] == value) return i;
+    }
+    return count;
+}
+
+void SmallIntSet::spill() {
+    dense.assign(inlineValues, inlineValues + count);
+    positionOf.reserve(count * 2);
+    for (std::size_t i = 0; i < count; ++i) positionOf.emplace(dense[i], i);
+    spilled = true;
+}
+
+bool SmallIntSet::insert(int value) {
+    if (!spilled) {
+        if (inlineIndexOf(value) != count) return false;
+        if (count < kInlineCapacity) {
+            inlineValues[count++] = value;
+            return true;
+        }
+        spill();
+    }
+    if (!positionOf.emplace(value, dense.size()).second) return false;
+    dense.push_back(value);
+    ++count;
+    return true;
+}
+
+bool SmallIntSet::erase(int value) {
+    if (!spilled) {
+        std::size_t i = inlineIndexOf(value);
+        if (i == count) return false;
+        inlineValues[i] = inlineValues[--count];
+        return true;
+    }
+    auto it = positionOf.find(value);
+    if (it == positionOf.end()) return false;
+    std::size_t pos = it->second;
+    positionOf.erase(it);
+    if (pos + 1 != dense.size()) {
+        dense[pos] = dense.back();
+        positionOf[dense[pos]] = pos;
+    }
+    dense.pop_back();
+    --count;
+    return true;
+}
+
+bool SmallIntSet::contains(int value) const {
+    if (!spilled) return inlineIndexOf(value) != count;
+    return positionOf.count(value) != 0;
+}
+
+void SmallIntSet::clear() {
+    dense.clear();
+    positionOf.clear();
+    count = 0;
+    spilled = false;
+}
@@ -0,0 +1,37 @@
+#ifndef SMALLINTSET_H
+#define SMALLINTSET_H
+
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+
+// 小整数集合：元素不超过 kInlineCapacity 时直接存放在对象内部、线性查找；
+// 超出后转为连续数组 + 哈希下标（删除时与末尾交换），插入/删除/查找均为 O(1)。
+// 两种模式下元素都连续存放，可直接按指针遍历（顺序不保证）。
+class SmallIntSet {
+public:
+    static constexpr std::size_t kInlineCapacity = 8;
+
+    bool insert(int value);   // 已存在时返回 false
+    bool erase(int value);    // 不存在时返回 false
+    bool contains(int value) const;
+    void clear();
+
+    std::size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+
+    const int* begin() const { return spilled ? dense.data() : inlineValues; }
+    const int* end() const { return begin() + count; }
+
+private:
+    int inlineValues[kInlineCapacity] = {};
+    std::size_t count = 0;
+    bool spilled = false;
+    std::vector<int> dense;                            // spilled 后的元素
+    std::unordered_map<int, std::size_t> positionOf;   // 元素 -> dense 下标
+
+    std::size_t inlineIndexOf(int value) const;
+    void spill();
+};
+
+#endif // SMALLINTSET_H
@@ -0,0 +1,37 @@
+#include "StringPool.h"
+
+#include <mutex>
+
+StringPool& StringPool::global() {
+    static StringPool pool;
+    return pool;
+}
+
+Symbol StringPool::intern(std::string_view text) {
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        auto it = lookup.find(text);
+        if (it != lookup.end()) return it->second;
+    }
+
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    auto it = lookup.find(text); // 可能已被其他线程插入
+    if (it != lookup.end()) return it->second;
+
+    storage.emplace_back(text);
+    const std::string& stored = storage.back();
+    Symbol symbol(&stored);
+    lookup.emplace(std::string_view(stored), symbol);
+    return symbol;
+}
+
+Symbol StringPool::find(std::string_view text) const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    auto it = lookup.find(text);
+    return (it != lookup.end()) ? it->second : Symbol();
+}
+
+std::size_t StringPool::size() const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return storage.size();
+}
@@ -0,0 +1,57 @@
+#ifndef STRINGPOOL_H
+#define STRINGPOOL_H
+
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+// 驻留字符串的句柄：同一个池中内容相同的字符串共享同一地址，
+// 因此比较、哈希都只是指针运算。
+class Symbol {
+public:
+    Symbol() = default;
+
+    bool valid() const { return text != nullptr; }
+    const std::string& str() const { static const std::string empty; return text ? *text : empty; }
+    std::string_view view() const { return text ? std::string_view(*text) : std::string_view(); }
+
+    bool operator==(const Symbol& other) const { return text == other.text; }
+    bool operator!=(const Symbol& other) const { return text != other.text; }
+
+    struct Hash {
+        std::size_t operator()(const Symbol& symbol) const { return std::hash<const void*>()(symbol.text); }
+    };
+
+private:
+    friend class StringPool;
+    explicit Symbol(const std::string* text) : text(text) {}
+    const std::string* text = nullptr;
+};
+
+class StringPool {
+public:
+    StringPool() = default;
+    StringPool(const StringPool&) = delete;
+    StringPool& operator=(const StringPool&) = delete;
+
+    // 进程内共享的驻留表，Book 的分类与作者都驻留在这里
+    static StringPool& global();
+
+    // 返回驻留后的句柄，不存在时插入（线程安全）
+    Symbol intern(std::string_view text);
+    // 只查找不插入，未驻留时返回无效句柄
+    Symbol find(std::string_view text) const;
+
+    std::size_t size() const;
+
+private:
+    mutable std::shared_mutex mutex;
+    std::deque<std::string> storage; // deque 尾部插入不移动已有元素
+    std::unordered_map<std::string_view, Symbol> lookup;
+};
+
+#endif // STRINGPOOL_H
@@ -50,6 +50,6 @@ void Student::displayStudentInfo() const {
     std::cout << "姓名: " << name << std::endl;
     std::cout << "专业: " << major << std::endl;
     std::cout << "借书上限: " << maxBorrowLimit << std::endl;
-    std::cout << "当前借书数量: " << currentBorrowCount << std::endl;
-    std::cout << "剩余可借数量: " << (maxBorrowLimit - currentBorrowCount) << std::endl;
+    std::cout << "当前借书数量: " << getCurrentBorrowCount() << std::endl;
+    std::cout << "剩余可借数量: " << (maxBorrowLimit - getCurrentBorrowCount()) << std::endl;
 }
\ No newline at end of file
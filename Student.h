@@ -16,6 +16,7 @@ public:
     
     // 虚函数
     std::string getType() const override { return "学生"; }
+    BorrowerKind getKind() const override { return BorrowerKind::Student; }
     void displayStudentInfo() const;
     void displayInfo() const override;
 
@@ -24,7 +25,7 @@ public:
     std::vector<Book*> browseBooksByCategory(Library& library, const std::string& category);
     
     // 获取器
-    std::string getMajor() const { return major; }
+    const std::string& getMajor() const { return major; }
     
     // 设置器
     void setMajor(const std::string& newMajor) { major = newMajor; }
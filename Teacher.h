@@ -15,10 +15,11 @@ public:
     
     // 重写虚函数
     std::string getType() const override { return "教师"; }
+    BorrowerKind getKind() const override { return BorrowerKind::Teacher; }
     void displayInfo() const override;
     
     // 获取器
-    std::string getTitle() const { return title; }
+    const std::string& getTitle() const { return title; }
     
     // 设置器
     void setTitle(const std::string& newTitle) { title = newTitle; }
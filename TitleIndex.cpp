@@ -0,0 +1,58 @@
+#include "TitleIndex.h"
+
+#include <utility>
+
+void TitleIndex::insert(std::size_t hash, std::size_t slot) {
+    if ((occupied + 1) * 4 > table.size() * 3) rehash(capacityFor(live + 1));
+    place(hash, static_cast<std::uint32_t>(slot));
+}
+
+bool TitleIndex::erase(std::size_t hash, std::size_t slot) {
+    if (table.empty()) return false;
+    for (std::size_t i = hash & mask();; i = (i + 1) & mask()) {
+        Entry& entry = table[i];
+        if (entry.state == kEmpty) return false;
+        if (entry.state == kFull && entry.hash == hash && entry.slot == slot) {
+            entry.state = kDeleted; // 留下删除标记，后面的项仍可探测到
+            --live;
+            return true;
+        }
+    }
+}
+
+void TitleIndex::clear() {
+    table.clear();
+    live = 0;
+    occupied = 0;
+}
+
+void TitleIndex::reserve(std::size_t count) {
+    std::size_t capacity = capacityFor(count);
+    if (capacity > table.size()) rehash(capacity);
+}
+
+// 重建后负载不超过一半
+std::size_t TitleIndex::capacityFor(std::size_t count) {
+    std::size_t capacity = 16;
+    while (capacity < count * 2) capacity *= 2;
+    return capacity;
+}
+
+// 总是放在第一个空位（不复用删除标记），同一哈希的项保持插入顺序
+void TitleIndex::place(std::uint64_t hash, std::uint32_t slot) {
+    std::size_t i = hash & mask();
+    while (table[i].state != kEmpty) i = (i + 1) & mask();
+    table[i] = Entry{hash, slot, kFull};
+    ++live;
+    ++occupied;
+}
+
+void TitleIndex::rehash(std::size_t capacity) {
+    std::vector<Entry> old = std::move(table);
+    table.assign(capacity, Entry{});
+    live = 0;
+    occupied = 0;
+    for (const Entry& entry : old) {
+        if (entry.state == kFull) place(entry.hash, entry.slot);
+    }
+}
@@ -0,0 +1,53 @@
+#ifndef TITLEINDEX_H
+#define TITLEINDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// 书名索引：以书名哈希为键的开放寻址表（线性探测）。每项只存哈希与槽位，
+// 插入不分配节点，批量载入时只需一次 reserve。同名或哈希相同的多本书各占一项，
+// 查找时按插入顺序逐个交给调用方比较原文。
+class TitleIndex {
+public:
+    static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+    void insert(std::size_t hash, std::size_t slot);
+    bool erase(std::size_t hash, std::size_t slot); // 不存在时返回 false
+    void clear();
+    void reserve(std::size_t count);
+    std::size_t size() const { return live; }
+
+    // 依次以哈希相同的槽位调用 match，返回第一个 match 为 true 的槽位，没有则返回 npos
+    template <typename Match>
+    std::size_t find(std::size_t hash, Match&& match) const {
+        if (table.empty()) return npos;
+        for (std::size_t i = hash & mask();; i = (i + 1) & mask()) {
+            const Entry& entry = table[i];
+            if (entry.state == kEmpty) return npos;
+            if (entry.state == kFull && entry.hash == hash && match(static_cast<std::size_t>(entry.slot))) {
+                return entry.slot;
+            }
+        }
+    }
+
+private:
+    enum : std::uint32_t { kEmpty = 0, kFull = 1, kDeleted = 2 };
+
+    struct Entry {
+        std::uint64_t hash = 0;
+        std::uint32_t slot = 0;
+        std::uint32_t state = kEmpty;
+    };
+
+    std::vector<Entry> table;  // 容量为 2 的幂，至少保留 1/4 空位
+    std::size_t live = 0;      // 有效项数
+    std::size_t occupied = 0;  // 有效项与删除标记之和，决定何时重建
+
+    std::size_t mask() const { return table.size() - 1; }
+    static std::size_t capacityFor(std::size_t count);
+    void place(std::uint64_t hash, std::uint32_t slot);
+    void rehash(std::size_t capacity);
+};
+
+#endif // TITLEINDEX_H
@@ -0,0 +1,292 @@
+#include "TsvFormat.h"
+#include "Student.h"
+#include "Teacher.h"
+
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+
+namespace tsv {
+
+namespace {
+
+constexpr std::size_t kMaxIntChars = 11; // "-2147483648"
+
+// 8 字节中是否有制表符或换行（SWAR：对应字节异或后为零的检测）
+inline bool hasEscapeByte(std::uint64_t word) {
+    constexpr std::uint64_t ones = 0x0101010101010101ULL;
+    constexpr std::uint64_t highs = 0x8080808080808080ULL;
+    const std::uint64_t tabs = word ^ (ones * '\t');
+    const std::uint64_t newlines = word ^ (ones * '\n');
+    return (((tabs - ones) & ~tabs) | ((newlines - ones) & ~newlines)) & highs;
+}
+
+// 以下写入函数要求调用方已按长度上界（转义后至多翻倍）预留空间。
+// 常见情形下字段不含需转义的字符：按 8 字节一块边检查边复制（不足一块的尾部与前一块重叠读取），
+// 避免变长 memcpy 调用；发现需转义的字符后再逐字节转义
+char* putEscaped(char* p, std::string_view s) {
+    const char* src = s.data();
+    const std::size_t n = s.size();
+    std::size_t i = 0;
+    if (n >= 8) {
+        std::uint64_t word;
+        for (; i + 8 <= n; i += 8) {
+            std::memcpy(&word, src + i, 8);
+            if (hasEscapeByte(word)) break;
+            std::memcpy(p + i, &word, 8);
+        }
+        if (i + 8 > n) {
+            if (i == n) return p + n;
+            std::memcpy(&word, src + n - 8, 8);
+            if (!hasEscapeByte(word)) {
+                std::memcpy(p + n - 8, &word, 8);
+                return p + n;
+            }
+        }
+    } else {
+        for (; i < n; ++i) {
+            const char c = src[i];
+            if (c == '\t' || c == '\n') break;
+            p[i] = c;
+        }
+        if (i == n) return p + n;
+    }
+    p += i;
+    for (; i < n; ++i) {
+        const char c = src[i];
+        if (c == '\t' || c == '\n') {
+            *p++ = '\\';
+            *p++ = c == '\t' ? 't' : 'n';
+        } else {
+            *p++ = c;
+        }
+    }
+    return p;
+}
+
+char* putInt(char* p, int value) {
+    if (static_cast<unsigned>(value) < 10) { // 副本数、借书上限多为一位数
+        *p = static_cast<char>('0' + value);
+        return p + 1;
+    }
+    return std::to_chars(p, p + kMaxIntChars, value).ptr;
+}
+
+// 一行图书/借阅人记录：先算上界，再整行写入
+struct BookRow {
+    explicit BookRow(const Book& book)
+        : book(book), title(book.getTitle()), author(book.getAuthor()),
+          isbn(book.getIsbn()), category(book.getCategory()) {}
+
+    std::size_t bound() const {
+        return 2 * (title.size() + author.size() + isbn.size() + category.size()) +
+               3 * kMaxIntChars + kBookFields - 1;
+    }
+    char* write(char* p) const {
+        p = putInt(p, book.getBookId());
+        *p++ = '\t';
+        p = putEscaped(p, title);
+        *p++ = '\t';
+        p = putEscaped(p, author);
+        *p++ = '\t';
+        p = putEscaped(p, isbn);
+        *p++ = '\t';
+        p = putEscaped(p, category);
+        *p++ = '\t';
+        p = putInt(p, book.getTotalCopies());
+        *p++ = '\t';
+        return putInt(p, book.getAvailableCopies());
+    }
+
+    const Book& book;
+    std::string_view title, author, isbn, category;
+};
+
+struct BorrowerRow {
+    // 按类型标签分派；类型名与 getType() 一致，载入时两种写法都接受
+    explicit BorrowerRow(const Borrower& borrower)
+        : borrower(borrower), id(borrower.getId()), name(borrower.getName()),
+          department(borrower.getDepartment()) {
+        switch (borrower.getKind()) {
+            case BorrowerKind::Student:
+                type = "学生";
+                extra = static_cast<const Student&>(borrower).getMajor();
+                break;
+            case BorrowerKind::Teacher:
+                type = "教师";
+                extra = static_cast<const Teacher&>(borrower).getTitle();
+                break;
+        }
+    }
+
+    std::size_t bound() const {
+        return 2 * (type.size() + id.size() + name.size() + department.size() + extra.size()) +
+               kMaxIntChars + kBorrowerFields - 1;
+    }
+    char* write(char* p) const {
+        p = putEscaped(p, type);
+        *p++ = '\t';
+        p = putEscaped(p, id);
+        *p++ = '\t';
+        p = putEscaped(p, name);
+        *p++ = '\t';
+        p = putEscaped(p, department);
+        *p++ = '\t';
+        p = putInt(p, borrower.getMaxBorrowLimit());
+        *p++ = '\t';
+        return putEscaped(p, extra);
+    }
+
+    const Borrower& borrower;
+    std::string_view type, id, name, department, extra;
+};
+
+// 追加到字符串：按上界扩容后写入，再截去未用部分
+template <typename Row>
+void appendRow(std::string& out, const Row& row) {
+    const std::size_t start = out.size();
+    out.resize(start + row.bound());
+    char* end = row.write(&out[start]);
+    out.resize(static_cast<std::size_t>(end - out.data()));
+}
+
+struct EscapedField {
+    std::string_view text;
+    std::size_t bound() const { return 2 * text.size(); }
+    char* write(char* p) const { return putEscaped(p, text); }
+};
+
+struct IntField {
+    int value;
+    std::size_t bound() const { return kMaxIntChars; }
+    char* write(char* p) const { return putInt(p, value); }
+};
+
+} // namespace
+
+void appendEscaped(std::string& out, std::string_view s) {
+    appendRow(out, EscapedField{s});
+}
+
+void appendInt(std::string& out, int value) {
+    appendRow(out, IntField{value});
+}
+
+std::string unescape(std::string_view s) {
+    // 绝大多数字段不含转义，直接构造
+    if (s.find('\\') == std::string_view::npos) return std::string(s);
+    std::string out;
+    out.reserve(s.size());
+    for (size_t i = 0; i < s.size(); ++i) {
+        char c = s[i];
+        if (c == '\\' && i + 1 < s.size()) {
+            char next = s[++i];
+            if (next == 't') out += '\t';
+            else if (next == 'n') out += '\n';
+            else out += next;
+        } else {
+            out += c;
+        }
+    }
+    return out;
+}
+
+bool parseInt(std::string_view text, int& value) {
+    const char* end = text.data() + text.size();
+    auto result = std::from_chars(text.data(), end, value);
+    return result.ec == std::errc() && result.ptr == end && !text.empty();
+}
+
+// 字段内的制表符已转义为反斜杠加 t，不会与分隔符混淆
+std::size_t split(std::string_view line, std::string_view* fields, std::size_t maxFields) {
+    std::size_t count = 0;
+    std::size_t start = 0;
+    while (count < maxFields) {
+        std::size_t tab = line.find('\t', start);
+        if (tab == std::string_view::npos) {
+            fields[count++] = line.substr(start);
+            break;
+        }
+        fields[count++] = line.substr(start, tab - start);
+        start = tab + 1;
+    }
+    return count;
+}
+
+void appendBook(std::string& out, const Book& book) {
+    appendRow(out, BookRow(book));
+}
+
+void appendBorrower(std::string& out, const Borrower& borrower) {
+    appendRow(out, BorrowerRow(borrower));
+}
+
+std::optional<Book> parseBook(std::string_view line, const char*& error) {
+    std::string_view parts[kBookFields];
+    if (split(line, parts, kBookFields) < kBookFields) {
+        error = "跳过非法图书记录";
+        return std::nullopt;
+    }
+    int id = 0, total = 0, available = 0;
+    if (!parseInt(parts[0], id) || !parseInt(parts[5], total) || !parseInt(parts[6], available)) {
+        error = "解析图书数字字段失败，记录已跳过";
+        return std::nullopt;
+    }
+    auto book = Book::withCounts(id, unescape(parts[1]), unescape(parts[2]),
+                                 unescape(parts[3]), unescape(parts[4]), total, available);
+    if (!book) error = "图书副本数不合法，记录已跳过";
+    return book;
+}
+
+std::unique_ptr<Borrower> parseBorrower(std::string_view line) {
+    std::string_view parts[kBorrowerFields];
+    if (split(line, parts, kBorrowerFields) < kBorrowerFields) return nullptr;
+    const std::string type = unescape(parts[0]);
+    int limit = 0;
+    if (!parseInt(parts[4], limit)) return nullptr;
+    const std::string id = unescape(parts[1]);
+    const std::string name = unescape(parts[2]);
+    const std::string dept = unescape(parts[3]);
+    const std::string extra = unescape(parts[5]);
+
+    if (type == "student" || type == "学生") {
+        return std::make_unique<Student>(id, name, dept, extra, limit);
+    }
+    if (type == "teacher" || type == "教师") {
+        return std::make_unique<Teacher>(id, name, dept, extra, limit);
+    }
+    return nullptr;
+}
+
+BufferedWriter::BufferedWriter(std::ostream& out, std::size_t capacity)
+    : out(out), storage(capacity) {}
+
+void BufferedWriter::writeBook(const Book& book) {
+    const BookRow row(book);
+    char* end = row.write(reserve(row.bound() + 1));
+    *end++ = '\n';
+    used = static_cast<std::size_t>(end - storage.data());
+}
+
+void BufferedWriter::writeBorrower(const Borrower& borrower) {
+    const BorrowerRow row(borrower);
+    char* end = row.write(reserve(row.bound() + 1));
+    *end++ = '\n';
+    used = static_cast<std::size_t>(end - storage.data());
+}
+
+char* BufferedWriter::reserve(std::size_t bound) {
+    if (used + bound > storage.size()) {
+        flush();
+        if (bound > storage.size()) storage.resize(bound); // 超长的单行
+    }
+    return storage.data() + used;
+}
+
+void BufferedWriter::flush() {
+    if (used == 0) return;
+    out.write(storage.data(), static_cast<std::streamsize>(used));
+    used = 0;
+}
+
+} // namespace tsv
@@ -0,0 +1,64 @@
+#ifndef TSVFORMAT_H
+#define TSVFORMAT_H
+
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Book.h"
+#include "Borrower.h"
+
+// books.tsv / users.tsv 的单行记录格式，FileManager 与 LibraryJournal 共用。
+// 字段以制表符分隔，字段内的制表符、换行转义为反斜杠加 t / n。
+namespace tsv {
+
+constexpr std::size_t kBookFields = 7;     // id 书名 作者 ISBN 分类 总数 可借数
+constexpr std::size_t kBorrowerFields = 6; // 类型 id 姓名 院系 借书上限 专业/职称
+
+// 追加到缓冲区末尾：字段直接转义写入，整数用 to_chars 格式化，不构造临时字符串
+void appendEscaped(std::string& out, std::string_view s);
+void appendInt(std::string& out, int value);
+std::string unescape(std::string_view s);
+bool parseInt(std::string_view text, int& value);
+
+// 按制表符原地切分，最多取 maxFields 个字段（多余字段忽略），返回实际字段数
+std::size_t split(std::string_view line, std::string_view* fields, std::size_t maxFields);
+
+// 追加一行记录（不含换行）
+void appendBook(std::string& out, const Book& book);
+void appendBorrower(std::string& out, const Borrower& borrower);
+
+// 解析一行记录；失败时返回空，并通过 error 给出原因
+std::optional<Book> parseBook(std::string_view line, const char*& error);
+std::unique_ptr<Borrower> parseBorrower(std::string_view line);
+
+// 大缓冲区写出器：每行按长度上界在缓冲区中预留空间，字段直接转义写入、整数用 to_chars 格式化，
+// 攒满 capacity 后一次写入流；析构时写出剩余部分
+class BufferedWriter {
+public:
+    static constexpr std::size_t kDefaultCapacity = std::size_t(1) << 20;
+
+    explicit BufferedWriter(std::ostream& out, std::size_t capacity = kDefaultCapacity);
+    ~BufferedWriter() { flush(); }
+    BufferedWriter(const BufferedWriter&) = delete;
+    BufferedWriter& operator=(const BufferedWriter&) = delete;
+
+    // 写入一行记录（含换行）
+    void writeBook(const Book& book);
+    void writeBorrower(const Borrower& borrower);
+    void flush();
+
+private:
+    std::ostream& out;
+    std::vector<char> storage;
+    std::size_t used = 0;
+
+    char* reserve(std::size_t bound); // 返回至少有 bound 字节空间的写入位置
+};
+
+} // namespace tsv
+
+#endif // TSVFORMAT_H
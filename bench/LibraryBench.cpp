@@ -0,0 +1,751 @@
+// 性能基准：cmake --build build --target library_bench && ./build/library_bench [分组名]
+#include "BookImporter.h"
+#include "BorrowHistory.h"
+#include "FileManager.h"
+#include "Library.h"
+#include "LibraryJournal.h"
+#include "LibraryLog.h"
+#include "TsvFormat.h"
+#include "Student.h"
+#include "Teacher.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+// 统计堆分配次数，供 alloc 分组比较按值/按引用访问器
+static std::atomic<std::size_t> allocationCount{0};
+
+// 所有形式的 new/delete 都经由同一对分配/释放函数，保证配对一致
+namespace {
+void* countedAllocate(std::size_t size) {
+    ++allocationCount;
+    return std::malloc(size ? size : 1);
+}
+// 不内联：否则 GCC 在调用处看到 free 作用于 operator new 的结果，报 -Wmismatched-new-delete
+[[gnu::noinline]] void countedRelease(void* p) noexcept { std::free(p); }
+} // namespace
+
+void* operator new(std::size_t size) {
+    if (void* p = countedAllocate(size)) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](std::size_t size) {
+    if (void* p = countedAllocate(size)) return p;
+    throw std::bad_alloc();
+}
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return countedAllocate(size); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return countedAllocate(size); }
+void operator delete(void* p) noexcept { countedRelease(p); }
+void operator delete[](void* p) noexcept { countedRelease(p); }
+void operator delete(void* p, std::size_t) noexcept { countedRelease(p); }
+void operator delete[](void* p, std::size_t) noexcept { countedRelease(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { countedRelease(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { countedRelease(p); }
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+template <typename Fn>
+double measureMs(Fn&& fn) {
+    auto start = Clock::now();
+    fn();
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+std::vector<Book> makeCatalogue(int count) {
+    std::vector<Book> books;
+    books.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        books.emplace_back(i + 1,
+                           "Title " + std::to_string(i),
+                           "Author " + std::to_string(i % 5000),
+                           "ISBN-" + std::to_string(i),
+                           "Category " + std::to_string(i % 200),
+                           1 + i % 5);
+    }
+    return books;
+}
+
+bool wanted(const std::string& only, const char* group) {
+    return only.empty() || only == group;
+}
+
+// 旧实现：逐本比较完整字符串
+std::size_t scanCategory(Library& library, const std::string& category) {
+    std::size_t hits = 0;
+    for (const auto& book : library.getBooks()) {
+        if (book.getCategory() == category) ++hits;
+    }
+    return hits;
+}
+
+std::size_t scanAuthor(Library& library, const std::string& author) {
+    std::size_t hits = 0;
+    for (const auto& book : library.getBooks()) {
+        if (book.getAuthor() == author) ++hits;
+    }
+    return hits;
+}
+
+const Book* scanTitle(Library& library, const std::string& title) {
+    for (const auto& book : library.getBooks()) {
+        if (book.getTitle() == title) return &book;
+    }
+    return nullptr;
+}
+
+void benchSecondaryIndexes() {
+    std::printf("\n== 二级索引: 线性扫描 vs 索引 (每次查询平均耗时, ms) ==\n");
+    std::printf("%10s %8s %12s %12s %10s\n", "books", "query", "scan", "indexed", "speedup");
+    const int queries = 20;
+    for (int count : {10000, 100000, 1000000}) {
+        Library library;
+        library.setBooks(makeCatalogue(count));
+
+        std::size_t sink = 0;
+        auto report = [&](const char* name, double scanMs, double indexMs) {
+            std::printf("%10d %8s %12.4f %12.4f %9.1fx\n", count, name,
+                        scanMs / queries, indexMs / queries, indexMs > 0 ? scanMs / indexMs : 0.0);
+        };
+
+        double scanMs = measureMs([&] {
+            for (int q = 0; q < queries; ++q) sink += scanCategory(library, "Category " + std::to_string(q * 7));
+        });
+        double indexMs = measureMs([&] {
+            for (int q = 0; q < queries; ++q) sink += library.findBooksByCategory("Category " + std::to_string(q * 7)).size();
+        });
+        report("category", scanMs, indexMs);
+
+        scanMs = measureMs([&] {
+            for (int q = 0; q < queries; ++q) sink += scanAuthor(library, "Author " + std::to_string(q * 31));
+        });
+        indexMs = measureMs([&] {
+            for (int q = 0; q < queries; ++q) sink += library.findBooksByAuthor("Author " + std::to_string(q * 31)).size();
+        });
+        report("author", scanMs, indexMs);
+
+        scanMs = measureMs([&] {
+            for (int q = 0; q < queries; ++q) sink += scanTitle(library, "Title " + std::to_string(count - 1 - q)) != nullptr;
+        });
+        indexMs = measureMs([&] {
+            for (int q = 0; q < queries; ++q) sink += library.findBookByTitle("Title " + std::to_string(count - 1 - q)) != nullptr;
+        });
+        report("title", scanMs, indexMs);
+
+        if (sink == 0) std::printf("(no hits)\n");
+    }
+}
+
+void benchHotColumns() {
+    std::printf("\n== 数值列扫描: Book 对象 vs 结构数组 (1M 本, 每轮平均耗时, ms) ==\n");
+    std::vector<Book> catalogue = makeCatalogue(1000000);
+    for (std::size_t i = 0; i < catalogue.size(); i += 3) catalogue[i].borrowBook();
+    Library library;
+    library.setBooks(catalogue);
+    const BookStore& books = library.getBooks();
+    const int rounds = 10;
+
+    long long sink = 0;
+    double objectMs = measureMs([&] {
+        for (int r = 0; r < rounds; ++r) {
+            long long total = 0, available = 0, titles = 0;
+            for (const auto& book : books) {
+                total += book.getTotalCopies();
+                available += book.getAvailableCopies();
+                if (book.getIsAvailable()) ++titles;
+            }
+            sink += total + available + titles;
+        }
+    });
+    double columnMs = measureMs([&] {
+        for (int r = 0; r < rounds; ++r) {
+            long long total = 0, available = 0, titles = 0;
+            for (std::size_t chunk = 0; chunk < books.chunkCount(); ++chunk) {
+                const BookStore::CountColumns columns = books.columns(chunk);
+                for (std::size_t i = 0; i < columns.size; ++i) {
+                    const int copies = columns.available(i);
+                    total += columns.total(i);
+                    available += copies;
+                    titles += copies > 0;
+                }
+            }
+            sink += total + available + titles;
+        }
+    });
+    std::printf("%-24s %10.3f\n", "Book objects", objectMs / rounds);
+    std::printf("%-24s %10.3f  (%.1fx)\n", "count columns", columnMs / rounds,
+                columnMs > 0 ? objectMs / columnMs : 0.0);
+    if (sink == 0) std::printf("(empty)\n");
+}
+
+void benchInterning() {
+    std::printf("\n== 分类/作者驻留 (1M 本) ==\n");
+    Library library;
+    library.setBooks(makeCatalogue(1000000));
+    const BookStore& books = library.getBooks();
+    std::printf("sizeof(Book) = %zu, 驻留字符串数 = %zu\n", sizeof(Book), StringPool::global().size());
+
+    const int rounds = 10;
+    const std::string wantedCategory = "Category 42";
+    const Symbol wantedSymbol = StringPool::global().find(wantedCategory);
+    std::size_t sink = 0;
+    double stringMs = measureMs([&] {
+        for (int r = 0; r < rounds; ++r) {
+            for (const auto& book : books) sink += book.getCategory() == wantedCategory;
+        }
+    });
+    double symbolMs = measureMs([&] {
+        for (int r = 0; r < rounds; ++r) {
+            for (const auto& book : books) sink += book.getCategorySymbol() == wantedSymbol;
+        }
+    });
+    std::printf("%-24s %10.3f\n", "string compare", stringMs / rounds);
+    std::printf("%-24s %10.3f  (%.1fx)\n", "symbol compare", symbolMs / rounds,
+                symbolMs > 0 ? stringMs / symbolMs : 0.0);
+    if (sink == 0) std::printf("(no hits)\n");
+}
+
+template <typename Fn>
+std::size_t countAllocations(Fn&& fn) {
+    std::size_t before = allocationCount.load();
+    fn();
+    return allocationCount.load() - before;
+}
+
+void benchAccessorAllocations() {
+    std::printf("\n== 访问器堆分配次数 (100k 本, 字段超出 SSO 长度) ==\n");
+    const int count = 100000;
+    Library library;
+    {
+        std::vector<Book> catalogue;
+        catalogue.reserve(count);
+        for (int i = 0; i < count; ++i) {
+            catalogue.emplace_back(i + 1,
+                                   "The Art of Computer Programming, Volume " + std::to_string(i),
+                                   "Donald Ervin Knuth the " + std::to_string(i % 5000) + "th",
+                                   "ISBN-978-0-201-" + std::to_string(1000000 + i),
+                                   "Computer Science / Algorithms " + std::to_string(i % 200),
+                                   1 + i % 5);
+        }
+        library.setBooks(catalogue);
+    }
+    const BookStore& books = library.getBooks();
+
+    std::size_t sink = 0;
+    // 改为返回引用之前，每次调用都会拷贝出一个 std::string
+    std::size_t byValue = countAllocations([&] {
+        for (const auto& book : books) {
+            std::string title = book.getTitle(), author = book.getAuthor();
+            std::string isbn = book.getIsbn(), category = book.getCategory();
+            sink += title.size() + author.size() + isbn.size() + category.size();
+        }
+    });
+    std::size_t byReference = countAllocations([&] {
+        for (const auto& book : books) {
+            sink += book.getTitle().size() + book.getAuthor().size()
+                  + book.getIsbn().size() + book.getCategory().size();
+        }
+    });
+    std::size_t titleLookups = countAllocations([&] {
+        for (int q = 0; q < 1000; ++q) sink += library.findBookByTitle("The Art of Computer Programming, Volume 42") != nullptr;
+    });
+    BorrowHistory history;
+    std::size_t historyRecords = countAllocations([&] {
+        for (int i = 0; i < 1000; ++i) history.record(i, i % 2 ? BorrowAction::Return : BorrowAction::Borrow);
+    });
+    auto path = std::filesystem::temp_directory_path() / "library_bench_books.tsv";
+    std::size_t save = countAllocations([&] { FileManager::saveBooksToFile(books, path.string()); });
+    std::filesystem::remove(path);
+
+    std::printf("%-28s %12zu\n", "4 fields, by value", byValue);
+    std::printf("%-28s %12zu\n", "4 fields, by reference", byReference);
+    std::printf("%-28s %12zu\n", "findBookByTitle x1000", titleLookups);
+    std::printf("%-28s %12zu\n", "saveBooksToFile", save);
+    std::printf("%-28s %12zu  (sizeof %zu)\n", "BorrowHistory::record x1000", historyRecords, sizeof(BorrowHistory));
+    if (sink == 0) std::printf("(empty)\n");
+}
+
+void benchLoanThroughput() {
+    std::printf("\n== 借还吞吐: 事件消息输出方式 (借+还 200k 次, ms) ==\n");
+    Library library;
+    library.setBooks(makeCatalogue(1000));
+    library.addBorrower(std::make_unique<Student>("S1", "Bench", "Dept", "Major", 1000));
+    const int cycles = 200000;
+
+    auto run = [&] {
+        return measureMs([&] {
+            for (int i = 0; i < cycles; ++i) {
+                int bookId = 1 + i % 1000;
+                library.checkout("S1", bookId);
+                library.checkin("S1", bookId);
+            }
+        });
+    };
+
+    // 旧行为：每行 std::endl 刷新一次（写到 /dev/null，只计格式化与系统调用开销）
+    std::ofstream devNull("/dev/null");
+    LibraryLog::setSink([&devNull](LogLevel, const std::string& message) { devNull << message << std::endl; },
+                        LogLevel::Debug);
+    double flushedMs = run();
+    LibraryLog::setSink(LibraryLog::consoleSink(), LogLevel::Off);
+    double filteredMs = run();
+    LibraryLog::reset();
+    double silentMs = run();
+
+    std::printf("%-28s %10.2f\n", "sink + endl per line", flushedMs);
+    std::printf("%-28s %10.2f  (%.1fx)\n", "sink, level filtered", filteredMs,
+                filteredMs > 0 ? flushedMs / filteredMs : 0.0);
+    std::printf("%-28s %10.2f  (%.1fx)\n", "default (no sink)", silentMs,
+                silentMs > 0 ? flushedMs / silentMs : 0.0);
+}
+
+// 旧实现：getline 逐行读取，每行切成 vector<string>，再逐字段转义、stoi 解析
+std::size_t loadBooksWithGetline(const std::string& filename) {
+    std::ifstream stream(filename);
+    std::vector<Book> books;
+    std::string line;
+    auto parseInt = [](const std::string& text, int& value) {
+        try {
+            std::size_t idx = 0;
+            value = std::stoi(text, &idx);
+            return idx == text.size();
+        } catch (...) {
+            return false;
+        }
+    };
+    auto unescape = [](const std::string& text) {
+        std::string out;
+        for (std::size_t i = 0; i < text.size(); ++i) {
+            if (text[i] == '\\' && i + 1 < text.size()) {
+                char next = text[++i];
+                out += next == 't' ? '\t' : next == 'n' ? '\n' : next;
+            } else {
+                out += text[i];
+            }
+        }
+        return out;
+    };
+    while (std::getline(stream, line)) {
+        if (line.empty()) continue;
+        std::vector<std::string> parts;
+        std::string current;
+        for (char c : line) {
+            if (c == '\t') {
+                parts.push_back(current);
+                current.clear();
+            } else {
+                current.push_back(c);
+            }
+        }
+        parts.push_back(current);
+        if (parts.size() < 7) continue;
+        int id = 0, total = 0, available = 0;
+        if (!parseInt(parts[0], id) || !parseInt(parts[5], total) || !parseInt(parts[6], available)) continue;
+        Book book(id, unescape(parts[1]), unescape(parts[2]), unescape(parts[3]), unescape(parts[4]), total);
+        for (int i = 0; i < total - available; ++i) book.borrowBook();
+        books.push_back(book);
+    }
+    return books.size();
+}
+
+void benchFileLoad() {
+    const int rows = 1000000;
+    std::printf("\n== 载入 books.tsv (%d 行, ms) ==\n", rows);
+    auto file = std::filesystem::temp_directory_path() / "library_bench_load.tsv";
+    {
+        std::ofstream out(file);
+        for (int i = 0; i < rows; ++i) {
+            out << i + 1 << "\tTitle " << i << "\tAuthor " << i % 5000 << "\tISBN-" << i
+                << "\tCategory " << i % 200 << '\t' << 1 + i % 5 << '\t' << i % 5 / 2 + 1 << '\n';
+        }
+    }
+
+    std::size_t oldCount = 0;
+    double oldMs = measureMs([&] { oldCount = loadBooksWithGetline(file.string()); });
+    std::printf("%-28s %10.2f  (%zu rows)\n", "getline + splitTsv + stoi", oldMs, oldCount);
+
+    // 分块并行解析，线程数从 1 递增到硬件并发数
+    const unsigned hardware = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned threads = 1; threads <= hardware; threads *= 2) {
+        std::vector<Book> books;
+        FileManager::setLoaderThreads(threads);
+        double newMs = measureMs([&] { FileManager::loadBooksFromFile(books, file.string()); });
+        char label[64];
+        std::snprintf(label, sizeof(label), "mmap + string_view, %u thr", threads);
+        std::printf("%-28s %10.2f  (%zu rows, %.1fx)\n", label, newMs, books.size(),
+                    newMs > 0 ? oldMs / newMs : 0.0);
+    }
+    FileManager::setLoaderThreads(0);
+    std::filesystem::remove(file);
+}
+
+// 旧实现：每个字段先转义成新字符串再经 operator<< 写出，借阅人按类型名与 dynamic_cast 取附加字段
+std::string escapeFieldCopy(const std::string& text) {
+    std::string out;
+    for (char c : text) {
+        if (c == '\t') out += "\\t";
+        else if (c == '\n') out += "\\n";
+        else out += c;
+    }
+    return out;
+}
+
+void saveWithOstream(const BookStore& books, const std::vector<std::unique_ptr<Borrower>>& borrowers,
+                     const std::string& booksFile, const std::string& usersFile) {
+    std::ofstream bookStream(booksFile);
+    for (const auto& book : books) {
+        bookStream << book.getBookId() << '\t' << escapeFieldCopy(book.getTitle()) << '\t'
+                   << escapeFieldCopy(book.getAuthor()) << '\t' << escapeFieldCopy(book.getIsbn()) << '\t'
+                   << escapeFieldCopy(book.getCategory()) << '\t' << book.getTotalCopies() << '\t'
+                   << book.getAvailableCopies() << '\n';
+    }
+    std::ofstream userStream(usersFile);
+    for (const auto& borrower : borrowers) {
+        std::string extra;
+        if (borrower->getType() == "学生") extra = dynamic_cast<const Student*>(borrower.get())->getMajor();
+        else if (borrower->getType() == "教师") extra = dynamic_cast<const Teacher*>(borrower.get())->getTitle();
+        userStream << escapeFieldCopy(borrower->getType()) << '\t' << escapeFieldCopy(borrower->getId()) << '\t'
+                   << escapeFieldCopy(borrower->getName()) << '\t' << escapeFieldCopy(borrower->getDepartment())
+                   << '\t' << borrower->getMaxBorrowLimit() << '\t' << escapeFieldCopy(extra) << '\n';
+    }
+}
+
+void benchFileSave() {
+    const int rows = 1000000;
+    std::printf("\n== 保存 books.tsv + users.tsv (各 %d 行, ms) ==\n", rows);
+    auto dir = std::filesystem::temp_directory_path();
+    auto booksFile = (dir / "library_bench_save_books.tsv").string();
+    auto usersFile = (dir / "library_bench_save_users.tsv").string();
+
+    Library library;
+    library.setBooks(makeCatalogue(rows));
+    std::vector<std::unique_ptr<Borrower>> borrowers;
+    borrowers.reserve(rows);
+    for (int i = 0; i < rows; ++i) {
+        const std::string id = "U" + std::to_string(i);
+        if (i % 4 == 0) borrowers.push_back(std::make_unique<Teacher>(id, "Name", "Dept", "讲师", 10));
+        else borrowers.push_back(std::make_unique<Student>(id, "Name", "Dept", "软件工程", 5));
+    }
+    library.setBorrowers(std::move(borrowers));
+
+    // 两种写法交替各跑 3 次取最快一次，减少前一次写出的脏页回写对后一次的干扰
+    double oldMs = 1e300, newMs = 1e300;
+    std::uintmax_t oldBytes = 0, newBytes = 0;
+    for (int round = 0; round < 3; ++round) {
+        oldMs = std::min(oldMs, measureMs([&] {
+            saveWithOstream(library.getBooks(), library.getBorrowers(), booksFile, usersFile);
+        }));
+        oldBytes = std::filesystem::file_size(booksFile) + std::filesystem::file_size(usersFile);
+        newMs = std::min(newMs, measureMs([&] {
+            FileManager::saveBooksToFile(library.getBooks(), booksFile);
+            FileManager::saveBorrowersToFile(library.getBorrowers(), usersFile);
+        }));
+        newBytes = std::filesystem::file_size(booksFile) + std::filesystem::file_size(usersFile);
+    }
+
+    std::printf("%-28s %10.2f  (%ju bytes)\n", "ofstream << + escape copy", oldMs, static_cast<std::uintmax_t>(oldBytes));
+    std::printf("%-28s %10.2f  (%ju bytes, %.1fx)\n", "buffered writer + to_chars", newMs,
+                static_cast<std::uintmax_t>(newBytes), newMs > 0 ? oldMs / newMs : 0.0);
+    std::filesystem::remove(booksFile);
+    std::filesystem::remove(usersFile);
+}
+
+void benchIncrementalSave() {
+    const int rows = 1000000;
+    const int loans = 10;
+    std::printf("\n== 退出时保存: %d 本图书 + %d 个借阅人, 其间借出 %d 本 (ms) ==\n", rows, rows, loans);
+    auto dir = std::filesystem::temp_directory_path();
+    auto booksFile = (dir / "library_bench_changes_books.tsv").string();
+    auto usersFile = (dir / "library_bench_changes_users.tsv").string();
+
+    Library library;
+    library.setBooks(makeCatalogue(rows));
+    std::vector<std::unique_ptr<Borrower>> borrowers;
+    borrowers.reserve(rows);
+    for (int i = 0; i < rows; ++i) {
+        borrowers.push_back(std::make_unique<Student>("U" + std::to_string(i), "Name", "Dept", "软件工程", 5));
+    }
+    library.setBorrowers(std::move(borrowers));
+    FileManager::saveLibrarySnapshot(library, booksFile, usersFile);
+
+    for (int i = 1; i <= loans; ++i) library.checkout("U" + std::to_string(i), i);
+    double fullMs = measureMs([&] { FileManager::saveLibrarySnapshot(library, booksFile, usersFile); });
+    // 数据库按修改记录写出的行数（此处不连接数据库，只统计行数）
+    LibraryChangeSet pending = library.takeChanges();
+    const std::size_t changedRows = pending.books.size() + pending.removedBooks.size() +
+                                    pending.borrowers.size() + pending.removedBorrowers.size();
+    library.restoreChanges(pending);
+    double changesMs = measureMs([&] { FileManager::saveLibraryChanges(library, booksFile, usersFile); });
+    double idleMs = measureMs([&] { FileManager::saveLibraryChanges(library, booksFile, usersFile); });
+
+    std::printf("%-28s %10.2f  (%d rows)\n", "full snapshot", fullMs, 2 * rows);
+    std::printf("%-28s %10.2f  (books.tsv only, %.1fx)\n", "changed files only", changesMs,
+                changesMs > 0 ? fullMs / changesMs : 0.0);
+    std::printf("%-28s %10.3f  (nothing written)\n", "no changes", idleMs);
+    std::printf("%-28s %10zu  (vs %d REPLACE)\n", "database rows to write", changedRows, 2 * rows);
+    std::filesystem::remove(booksFile);
+    std::filesystem::remove(usersFile);
+}
+
+void benchLogin() {
+    const int users = 60000;
+    const int logins = 1000;
+    std::printf("\n== 文件模式登录: %d 个用户 (每次登录, us) ==\n", users);
+    auto usersFile = (std::filesystem::temp_directory_path() / "library_bench_login_users.tsv").string();
+    std::vector<std::unique_ptr<Borrower>> borrowers;
+    borrowers.reserve(users);
+    for (int i = 0; i < users; ++i) {
+        borrowers.push_back(std::make_unique<Student>(std::to_string(2023000000 + i), "Name", "Dept", "软件工程", 5));
+    }
+    FileManager::saveBorrowersToFile(borrowers, usersFile);
+
+    // 旧做法：每次登录重新解析整个文件，为每行构造借阅人
+    std::size_t found = 0;
+    double reloadMs = measureMs([&] {
+        for (int i = 0; i < logins / 20; ++i) {
+            std::vector<std::unique_ptr<Borrower>> all;
+            FileManager::loadBorrowersFromFile(all, usersFile);
+            const std::string id = std::to_string(2023000000 + i * 997 % users);
+            for (const auto& user : all) {
+                if (user->getId() == id) {
+                    ++found;
+                    break;
+                }
+            }
+        }
+    });
+    const double indexMs = measureMs([&] { delete FileManager::loginUser(usersFile, "2023000000", "000000"); });
+    const std::size_t before = allocationCount.load();
+    double cachedMs = measureMs([&] {
+        for (int i = 0; i < logins; ++i) {
+            const std::string id = std::to_string(2023000000 + i * 997 % users);
+            std::unique_ptr<Borrower> user(FileManager::loginUser(usersFile, id, id.substr(id.size() - 6)));
+            if (user) ++found;
+        }
+    });
+    const double allocationsPerLogin = static_cast<double>(allocationCount.load() - before) / logins;
+
+    const double reloadUs = reloadMs * 1000.0 / (logins / 20);
+    const double cachedUs = cachedMs * 1000.0 / logins;
+    std::printf("%-28s %10.2f\n", "reparse users file", reloadUs);
+    std::printf("%-28s %10.2f\n", "first login (build index)", indexMs * 1000.0);
+    std::printf("%-28s %10.2f  (%.1f allocs/login incl. result, %.0fx)\n", "cached credential index", cachedUs,
+                allocationsPerLogin, cachedUs > 0 ? reloadUs / cachedUs : 0.0);
+    if (found != static_cast<std::size_t>(logins + logins / 20)) std::printf("unexpected login misses\n");
+    std::filesystem::remove(usersFile);
+}
+
+void benchSnapshots() {
+    const int count = 1000000;
+    std::printf("\n== 快照冷启动: %d 本图书 (ms) ==\n", count);
+    auto dir = std::filesystem::temp_directory_path();
+    auto booksFile = (dir / "library_bench_books.tsv").string();
+    auto usersFile = (dir / "library_bench_users.tsv").string();
+    auto binaryFile = (dir / "library_bench_snapshot.bin").string();
+
+    double tsvSaveMs = 0, binarySaveMs = 0, tsvLoadMs = 0, binaryLoadMs = 0;
+    std::size_t tsvBooks = 0, binaryBooks = 0;
+    {
+        Library library;
+        library.setBooks(makeCatalogue(count));
+        library.addBorrower(std::make_unique<Student>("S1", "Bench", "Dept", "Major", 1000));
+        tsvSaveMs = measureMs([&] { FileManager::saveLibrarySnapshot(library, booksFile, usersFile); });
+        binarySaveMs = measureMs([&] { FileManager::saveBinarySnapshot(library, binaryFile); });
+    }
+    // 每次载入到新的 Library，载入之间释放上一份，避免内存压力干扰
+    {
+        Library fromTsv;
+        tsvLoadMs = measureMs([&] { FileManager::loadLibrarySnapshot(fromTsv, booksFile, usersFile); });
+        tsvBooks = fromTsv.getBooks().size();
+    }
+    {
+        Library fromBinary;
+        binaryLoadMs = measureMs([&] { FileManager::loadBinarySnapshot(fromBinary, binaryFile); });
+        binaryBooks = fromBinary.getBooks().size();
+    }
+
+    std::printf("%-28s %10.2f  (%ju bytes)\n", "TSV save", tsvSaveMs,
+                static_cast<std::uintmax_t>(std::filesystem::file_size(booksFile)));
+    std::printf("%-28s %10.2f  (%ju bytes)\n", "binary save", binarySaveMs,
+                static_cast<std::uintmax_t>(std::filesystem::file_size(binaryFile)));
+    std::printf("%-28s %10.2f  (%zu books)\n", "TSV load", tsvLoadMs, tsvBooks);
+    std::printf("%-28s %10.2f  (%zu books, %.1fx)\n", "binary load", binaryLoadMs, binaryBooks,
+                binaryLoadMs > 0 ? tsvLoadMs / binaryLoadMs : 0.0);
+    std::filesystem::remove(booksFile);
+    std::filesystem::remove(usersFile);
+    std::filesystem::remove(binaryFile);
+}
+
+void benchJournal() {
+    const int count = 100000;
+    const int loans = 100000;
+    std::printf("\n== 文件模式的借还持久化: %d 本图书 (每次借还的耗时, us) ==\n", count);
+    auto dir = std::filesystem::temp_directory_path();
+    auto booksFile = (dir / "library_bench_books.tsv").string();
+    auto usersFile = (dir / "library_bench_users.tsv").string();
+    auto journalFile = (dir / "library_bench.journal").string();
+    std::filesystem::remove(journalFile);
+
+    Library library;
+    library.setBooks(makeCatalogue(count));
+    library.addBorrower(std::make_unique<Student>("S1", "Bench", "Dept", "Major", 1000));
+
+    // 旧做法：每次借还后重写整个快照
+    const int rewrites = 10;
+    double rewriteMs = measureMs([&] {
+        for (int i = 1; i <= rewrites; ++i) {
+            library.checkout("S1", i);
+            FileManager::saveLibrarySnapshot(library, booksFile, usersFile);
+        }
+    });
+    for (int i = 1; i <= rewrites; ++i) library.checkin("S1", i);
+
+    // 追加日志：借还只追加一行，后台批量 fsync
+    LibraryJournal::Options options;
+    options.compactBytes = std::size_t(1) << 30; // 只测追加，不触发压缩
+    LibraryJournal journal(library, journalFile, booksFile, usersFile, options);
+    journal.start();
+    double journalMs = measureMs([&] {
+        for (int i = 0; i < loans / 2; ++i) {
+            const int bookId = 1 + i % count;
+            library.checkout("S1", bookId);
+            library.checkin("S1", bookId);
+        }
+        journal.sync();
+    });
+    const std::uint64_t journalBytes = journal.journalBytes();
+    journal.stop();
+
+    const double rewriteUs = rewriteMs * 1000.0 / rewrites;
+    const double journalUs = journalMs * 1000.0 / loans;
+    std::printf("%-28s %10.2f\n", "snapshot rewrite", rewriteUs);
+    std::printf("%-28s %10.2f  (%ju bytes, %.0fx)\n", "journal append", journalUs,
+                static_cast<std::uintmax_t>(journalBytes), journalUs > 0 ? rewriteUs / journalUs : 0.0);
+    std::filesystem::remove(booksFile);
+    std::filesystem::remove(usersFile);
+    std::filesystem::remove(journalFile);
+}
+
+void benchImport() {
+    const int count = 300000;
+    std::printf("\n== 批量导入 CSV: %d 本图书 (ms) ==\n", count);
+    auto csvFile = (std::filesystem::temp_directory_path() / "library_bench_import.csv").string();
+    {
+        std::ofstream out(csvFile, std::ios::binary | std::ios::trunc);
+        out << "ID,书名,作者,ISBN,分类,总数\n";
+        for (const auto& book : makeCatalogue(count)) {
+            out << book.getBookId() << ",\"" << book.getTitle() << "\"," << book.getAuthor() << ','
+                << book.getIsbn() << ',' << book.getCategory() << ',' << book.getTotalCopies() << '\n';
+        }
+    }
+    LibraryLog::setSink(LibraryLog::consoleSink(), LogLevel::Off);
+
+    // 旧做法：单线程逐行读取、切分，每本书单独加锁 addBook
+    Library rowByRow;
+    double rowMs = measureMs([&] {
+        std::ifstream in(csvFile);
+        std::string line;
+        std::getline(in, line); // 表头
+        while (std::getline(in, line)) {
+            std::vector<std::string> fields;
+            std::size_t start = 0;
+            for (std::size_t comma; (comma = line.find(',', start)) != std::string::npos; start = comma + 1) {
+                fields.push_back(line.substr(start, comma - start));
+            }
+            fields.push_back(line.substr(start));
+            if (fields.size() < 6) continue;
+            int id = 0, total = 0;
+            if (!tsv::parseInt(fields[0], id) || !tsv::parseInt(fields[5], total)) continue;
+            std::string title = fields[1].substr(1, fields[1].size() - 2);
+            rowByRow.addBook(Book(id, title, fields[2], fields[3], fields[4], total));
+        }
+    });
+
+    Library pipelined;
+    BookImporter::Result result;
+    double pipelineMs = measureMs([&] {
+        result = BookImporter().run(csvFile, [&](const std::vector<Book>& batch) { return pipelined.addBooks(batch); });
+    });
+    LibraryLog::reset();
+
+    std::printf("%-28s %10.1f\n", "getline + addBook per row", rowMs);
+    std::printf("%-28s %10.1f  (%.1fx)\n", "pipeline + addBooks", pipelineMs, pipelineMs > 0 ? rowMs / pipelineMs : 0.0);
+    if (!result.ok || result.progress.imported != static_cast<std::size_t>(count) ||
+        rowByRow.getBooks().size() != pipelined.getBooks().size()) {
+        std::printf("unexpected import result\n");
+    }
+    std::filesystem::remove(csvFile);
+}
+
+void benchCopyContention() {
+    std::printf("\n== 单本图书争用: 借+还共 2M 次 (ms) ==\n");
+    std::printf("%-10s %14s %14s\n", "threads", "mutex", "atomic CAS");
+    const int totalCycles = 2000000;
+
+    for (int threads : {1, 4, 16, 64}) {
+        const int perThread = totalCycles / threads;
+        auto hammer = [&](auto cycle) {
+            return measureMs([&] {
+                std::vector<std::thread> workers;
+                for (int t = 0; t < threads; ++t) {
+                    workers.emplace_back([&] {
+                        for (int i = 0; i < perThread; ++i) cycle();
+                    });
+                }
+                for (auto& worker : workers) worker.join();
+            });
+        };
+
+        // 旧做法：先判断再减一，需要一把锁保护
+        std::mutex mutex;
+        int copies = 64;
+        double mutexMs = hammer([&] {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (copies > 0) --copies;
+            }
+            std::lock_guard<std::mutex> lock(mutex);
+            if (copies < 64) ++copies;
+        });
+
+        Book book(1, "Popular", "Author", "ISBN", "Category", 64);
+        double atomicMs = hammer([&] {
+            if (book.borrowBook()) book.returnBook();
+        });
+        if (book.getAvailableCopies() != 64 || copies != 64) std::printf("(copies mismatch)\n");
+
+        std::printf("%-10d %14.2f %14.2f  (%.1fx)\n", threads, mutexMs, atomicMs,
+                    atomicMs > 0 ? mutexMs / atomicMs : 0.0);
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const std::string only = argc > 1 ? argv[1] : "";
+    if (wanted(only, "index")) benchSecondaryIndexes();
+    if (wanted(only, "columns")) benchHotColumns();
+    if (wanted(only, "intern")) benchInterning();
+    if (wanted(only, "alloc")) benchAccessorAllocations();
+    if (wanted(only, "loans")) benchLoanThroughput();
+    if (wanted(only, "contention")) benchCopyContention();
+    if (wanted(only, "load")) benchFileLoad();
+    if (wanted(only, "save")) benchFileSave();
+    if (wanted(only, "changes")) benchIncrementalSave();
+    if (wanted(only, "login")) benchLogin();
+    if (wanted(only, "snapshot")) benchSnapshots();
+    if (wanted(only, "journal")) benchJournal();
+    if (wanted(only, "import")) benchImport();
+    return 0;
+}
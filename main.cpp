@@ -1,9 +1,27 @@
 #include "Library.h"
+#include "LibraryLog.h"
 #include "src/cli/LibraryCliController.h"
 
-int main() {
+#include <cstring>
+#include <iostream>
+
+int main(int argc, char** argv) {
+    // 核心库默认静默，命令行前端把事件消息输出到控制台
+    LibraryLog::setSink(LibraryLog::consoleSink(), LogLevel::Info);
     Library library("小Z图书馆", "C++面向对象课程设计-zzc");
     cli::LibraryCliController controller(library);
+
+    // library_cli import <文件>：批量导入图书后退出
+    if (argc > 1 && std::strcmp(argv[1], "import") == 0) {
+        if (argc != 3) {
+            std::cerr << "用法: " << argv[0] << " import <books.csv|books.tsv>" << std::endl;
+            return 2;
+        }
+        LibraryLog::setSink(LibraryLog::consoleSink(), LogLevel::Warning); // 逐批的添加消息不必输出
+        controller.bootstrap();
+        return controller.importBooks(argv[2]) ? 0 : 1;
+    }
+
     controller.bootstrap();
     controller.run();
     return 0;
@@ -1,6 +1,7 @@
 #include "src/cli/LibraryCliController.h"
 
 #include "Book.h"
+#include "BookImporter.h"
 #include "Borrower.h"
 #include "FileManager.h"
 #include "Library.h"
@@ -11,6 +12,7 @@
 #include <algorithm>
 #include <iostream>
 #include <limits>
+#include <map>
 #include <sstream>
 #include <vector>
 
@@ -46,7 +48,7 @@ std::string promptLine(const std::string& message, const std::string& defaultVal
 namespace cli {
 
 LibraryCliController::LibraryCliController(Library& library)
-    : library_(library) {}
+    : library_(library), journal_(library, journalFile_, booksFile_, usersFile_) {}
 
 void LibraryCliController::bootstrap() {
 #ifdef USE_MYSQL
@@ -58,6 +60,9 @@ void LibraryCliController::bootstrap() {
     if (!loadLibrary()) {
         initializeFallbackData();
     }
+    if (!dbMode_ && !journal_.start()) {
+        std::cout << "无法启用修改日志，修改只在手动保存时写入文件。" << std::endl;
+    }
 }
 
 void LibraryCliController::run() {
@@ -101,6 +106,7 @@ void LibraryCliController::showAdminMenu() const {
     std::cout << "8. 删除用户" << std::endl;
     std::cout << "9. 保存数据" << std::endl;
     std::cout << "10. 加载数据" << std::endl;
+    std::cout << "11. 批量导入图书 (CSV/TSV)" << std::endl;
     std::cout << "0. 返回主菜单" << std::endl;
 }
 
@@ -125,7 +131,7 @@ void LibraryCliController::handleAdminSession() {
     bool adminRunning = true;
     while (adminRunning) {
         showAdminMenu();
-        int choice = promptInt("请选择操作 (0-10): ");
+        int choice = promptInt("请选择操作 (0-11): ");
         processAdminChoice(choice, adminRunning);
     }
 }
@@ -201,6 +207,9 @@ void LibraryCliController::processAdminChoice(int choice, bool& keepRunning) {
         case 10:
             loadLibrary();
             break;
+        case 11:
+            importBooks(promptLine("请输入导入文件路径: "));
+            break;
         case 0:
             keepRunning = false;
             std::cout << "已退出管理员模式！" << std::endl;
@@ -247,7 +256,7 @@ void LibraryCliController::processUserChoice(Borrower* user, int choice, bool& k
             user->displayBorrowedBooks(library_);
             break;
         case 7:
-            user->displayBorrowHistory();
+            user->displayBorrowHistory(library_);
             break;
         case 0:
             keepRunning = false;
@@ -267,7 +276,10 @@ void LibraryCliController::promptAndAddBook() {
     int copies = promptInt("请输入总数量: ");
 
     Book book(id, title, author, isbn, category, copies);
-    library_.addBook(book);
+    if (!library_.addBook(book)) {
+        std::cout << "添加失败：ID为 " << id << " 的图书已存在。" << std::endl;
+        return;
+    }
 #ifdef USE_MYSQL
     if (dbMode_) {
         syncBookToDatabase(id);
@@ -296,15 +308,16 @@ void LibraryCliController::promptAndAddUser() {
     std::string department = promptLine("请输入院系: ");
     int limit = promptInt("请输入最大借阅数量: ");
 
+    [[maybe_unused]] bool added = false; // 仅数据库模式下使用
     if (type == 1) {
         std::string major = promptLine("请输入专业: ");
-        library_.addBorrower(new Student(id, name, department, major, limit));
+        added = library_.addBorrower(std::make_unique<Student>(id, name, department, major, limit));
     } else {
         std::string title = promptLine("请输入职称: ");
-        library_.addBorrower(new Teacher(id, name, department, title, limit));
+        added = library_.addBorrower(std::make_unique<Teacher>(id, name, department, title, limit));
     }
 #ifdef USE_MYSQL
-    if (dbMode_) {
+    if (dbMode_ && added) {
         Borrower* borrower = library_.findBorrowerById(id);
         if (borrower) {
             withDbConnection([&](db::DBManager& mgr) { mgr.upsertBorrower(borrower); });
@@ -325,34 +338,87 @@ void LibraryCliController::promptAndRemoveUser() {
 
 void LibraryCliController::handleBorrowFlow(Borrower* user) {
     int bookId = promptInt("请输入要借阅的图书ID: ");
-    if (user->borrowBookFromLibrary(library_, bookId)) {
-        if (Book* book = library_.findBookById(bookId)) {
-            recommendation_.recordBorrow(bookId, book->getCategory());
-        }
+    LoanResult result = library_.checkout(user->getId(), bookId, Library::kDefaultLoanDays);
+    if (result != LoanResult::Ok) {
+        std::cout << "借书失败: " << loanResultMessage(result) << std::endl;
+        return;
+    }
+    if (Book* book = library_.findBookById(bookId)) {
+        recommendation_.recordBorrow(bookId, book->getCategory());
+    }
 #ifdef USE_MYSQL
-        if (dbMode_) {
-            syncBookToDatabase(bookId);
-        }
-#endif
+    if (dbMode_) {
+        withDbConnection([&](db::DBManager& mgr) {
+            mgr.createBorrowRecord(user->getId(), bookId, Library::kDefaultLoanDays);
+        });
+        syncBookToDatabase(bookId);
     }
+#endif
 }
 
 void LibraryCliController::handleReturnFlow(Borrower* user) {
     int bookId = promptInt("请输入要归还的图书ID: ");
-    if (user->returnBookToLibrary(library_, bookId)) {
+    LoanResult result = library_.checkin(user->getId(), bookId);
+    if (result != LoanResult::Ok) {
+        std::cout << "还书失败: " << loanResultMessage(result) << std::endl;
+        return;
+    }
 #ifdef USE_MYSQL
-        if (dbMode_) {
-            syncBookToDatabase(bookId);
-        }
-#endif
+    if (dbMode_) {
+        withDbConnection([&](db::DBManager& mgr) { mgr.returnBorrowRecord(bookId, user->getId()); });
+        syncBookToDatabase(bookId);
     }
+#endif
 }
 
 void LibraryCliController::initializeFallbackData() {
     library_.initializeWithSampleBooks();
-    library_.addBorrower(new Student("56666666666", "zzc", "计算机学院", "信息安全", 5));
-    library_.addBorrower(new Student("2023002", "李四", "文学院", "汉语言文学", 5));
-    library_.addBorrower(new Teacher("T2023001", "王教授", "计算机学院", "教授", 10));
+    library_.addBorrower(std::make_unique<Student>("56666666666", "zzc", "计算机学院", "信息安全", 5));
+    library_.addBorrower(std::make_unique<Student>("2023002", "李四", "文学院", "汉语言文学", 5));
+    library_.addBorrower(std::make_unique<Teacher>("T2023001", "王教授", "计算机学院", "教授", 10));
+}
+
+bool LibraryCliController::importBooks(const std::string& filename) {
+    BookImporter importer;
+    BookImporter::Result result;
+    auto printProgress = [](const BookImporter::Progress& progress) {
+        const int percent = progress.totalBytes ? static_cast<int>(progress.bytesRead * 100 / progress.totalBytes) : 100;
+        std::cout << "\r已导入 " << progress.imported << " 本，已读取 " << percent << "%" << std::flush;
+        return true;
+    };
+    auto run = [&](const BookImporter::Sink& sink) { result = importer.run(filename, sink, printProgress); };
+
+    bool imported = false;
+#ifdef USE_MYSQL
+    if (dbMode_) {
+        // 每批加入目录后随即写入数据库，整个导入共用一个连接
+        imported = withDbConnection([&](db::DBManager& mgr) {
+            run([&](const std::vector<Book>& batch) -> std::size_t {
+                const std::size_t added = library_.addBooks(batch);
+                LibraryChangeSet changes = library_.takeChanges();
+                if (!mgr.saveChanges(library_, changes)) {
+                    library_.restoreChanges(changes);
+                    return BookImporter::kSinkFailed;
+                }
+                return added;
+            });
+        });
+    }
+#endif
+    if (!imported) {
+        run([this](const std::vector<Book>& batch) { return library_.addBooks(batch); });
+    }
+    std::cout << std::endl;
+
+    const BookImporter::Progress& progress = result.progress;
+    std::cout << "导入完成: 新增 " << progress.imported << " 本，ID 已存在跳过 " << progress.skipped
+              << " 本，非法记录 " << progress.rejected << " 条" << std::endl;
+    for (const auto& error : result.errors) {
+        std::cout << "  " << error << std::endl;
+    }
+    // 文件模式下日志已记下每本新书，保存即写出新快照；数据库模式下未能写入数据库的部分也在这里补写
+    if (progress.imported > 0) saveLibrary();
+    return result.ok;
 }
 
 bool LibraryCliController::saveLibrary() {
@@ -374,12 +440,19 @@ bool LibraryCliController::loadLibrary() {
     return loadFromFiles();
 }
 
-bool LibraryCliController::saveToFiles() const {
-    return FileManager::saveLibrarySnapshot(library_, booksFile_, usersFile_);
+bool LibraryCliController::saveToFiles() {
+    // 日志开启时每次修改已写入日志，保存即压缩为新快照
+    if (journal_.isRunning()) return journal_.checkpoint();
+    return FileManager::saveLibraryChanges(library_, booksFile_, usersFile_);
 }
 
 bool LibraryCliController::loadFromFiles() {
-    return FileManager::loadLibrarySnapshot(library_, booksFile_, usersFile_);
+    // 重新载入期间停止记录，避免把重放的修改再次写入日志
+    const bool journaling = journal_.isRunning();
+    journal_.stop();
+    bool loaded = FileManager::loadLibrarySnapshot(library_, booksFile_, usersFile_, journalFile_);
+    if (journaling) journal_.start();
+    return loaded;
 }
 
 #ifdef USE_MYSQL
@@ -438,24 +511,32 @@ bool LibraryCliController::loadLibraryFromDatabase() {
     bool loaded = false;
     withDbConnection([&](db::DBManager& mgr) {
         std::vector<Book> books;
-        std::vector<Borrower*> borrowers;
+        std::vector<std::unique_ptr<Borrower>> borrowers;
         if (mgr.loadBooks(books)) {
             library_.setBooks(books);
             loaded = true;
         }
         if (mgr.loadBorrowers(borrowers)) {
-            library_.setBorrowers(borrowers);
+            library_.setBorrowers(std::move(borrowers));
             loaded = true;
         }
+        // 把数据库中未归还的借阅记录重新归属到借阅人名下
+        std::vector<std::map<std::string, std::string>> records;
+        if (loaded && mgr.getAllBorrowRecords(records)) {
+            db::restoreOutstandingLoans(library_, records);
+        }
     });
     return loaded;
 }
 
 bool LibraryCliController::persistLibraryToDatabase() {
-    return withDbConnection([&](db::DBManager& mgr) {
-        mgr.saveBooks(library_.getBooks());
-        mgr.saveBorrowers(library_.getBorrowers());
-    });
+    // 只写出自载入以来修改过的行，未修改的目录不再整表 REPLACE
+    LibraryChangeSet changes = library_.takeChanges();
+    if (changes.empty()) return true;
+    bool saved = false;
+    withDbConnection([&](db::DBManager& mgr) { saved = mgr.saveChanges(library_, changes); });
+    if (!saved) library_.restoreChanges(changes);
+    return saved;
 }
 
 bool LibraryCliController::syncBookToDatabase(int bookId) {
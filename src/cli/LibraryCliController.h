@@ -4,6 +4,7 @@
 #include <optional>
 #include <string>
 
+#include "LibraryJournal.h"
 #include "src/cli/BookRecommendationService.h"
 
 #ifdef USE_MYSQL
@@ -32,6 +33,8 @@ public:
 
     void bootstrap();
     void run();
+    // 从 CSV/TSV 批量导入图书并保存（library_cli import <文件> 与管理员菜单共用）
+    bool importBooks(const std::string& filename);
 
 private:
     Library& library_;
@@ -39,6 +42,8 @@ private:
     std::optional<DbConfig> dbConfig_;
     std::string booksFile_ = "books.tsv";
     std::string usersFile_ = "users.tsv";
+    std::string journalFile_ = "library.journal";
+    LibraryJournal journal_; // 文件模式下记录每次修改，保存时写出新快照
     BookRecommendationService recommendation_;
 
     void showMainMenu() const;
@@ -77,7 +82,7 @@ private:
     bool syncBookToDatabase(int) { return false; }
 #endif
     bool loadFromFiles();
-    bool saveToFiles() const;
+    bool saveToFiles();
 };
 
 } // namespace cli
@@ -1,8 +1,13 @@
 #include "src/db/DBManager.h"
 #include "Book.h"
+#include "BookStore.h"
+#include "Library.h"
 #include "Student.h"
 #include "Teacher.h"
 #include <iostream>
+#include <string_view>
+#include <cstdlib>
+#include <cstring>
 
 #ifdef USE_MYSQL
 #if __has_include(<mysql/mysql.h>)
@@ -23,6 +28,40 @@ struct db::DBManager::Impl {
 };
 
 using namespace std;
+
+#ifdef USE_MYSQL
+namespace {
+const char* kReplaceBookSql = "REPLACE INTO books (id,title,author,isbn,category,total,available) VALUES (?,?,?,?,?,?,?)";
+
+MYSQL_STMT* prepareStatement(MYSQL* conn, const char* sql) {
+    MYSQL_STMT* stmt = mysql_stmt_init(conn);
+    if (!stmt) { cerr << "mysql_stmt_init failed: " << mysql_error(conn) << endl; return nullptr; }
+    if (mysql_stmt_prepare(stmt, sql, strlen(sql)) != 0) {
+        cerr << "prepare failed: " << mysql_stmt_error(stmt) << endl;
+        mysql_stmt_close(stmt);
+        return nullptr;
+    }
+    return stmt;
+}
+
+// 以一本书的字段执行已准备好的 REPLACE INTO books
+bool executeBookReplace(MYSQL_STMT* stmt, const Book& b) {
+    MYSQL_BIND bind[7]; memset(bind, 0, sizeof(bind));
+    int id = b.getBookId(); bind[0].buffer_type = MYSQL_TYPE_LONG; bind[0].buffer = (char*)&id;
+    const string& title = b.getTitle(); bind[1].buffer_type = MYSQL_TYPE_STRING; bind[1].buffer = (char*)title.c_str(); bind[1].buffer_length = title.size();
+    const string& author = b.getAuthor(); bind[2].buffer_type = MYSQL_TYPE_STRING; bind[2].buffer = (char*)author.c_str(); bind[2].buffer_length = author.size();
+    const string& isbn = b.getIsbn(); bind[3].buffer_type = MYSQL_TYPE_STRING; bind[3].buffer = (char*)isbn.c_str(); bind[3].buffer_length = isbn.size();
+    const string& category = b.getCategory(); bind[4].buffer_type = MYSQL_TYPE_STRING; bind[4].buffer = (char*)category.c_str(); bind[4].buffer_length = category.size();
+    int total = b.getTotalCopies(); bind[5].buffer_type = MYSQL_TYPE_LONG; bind[5].buffer = (char*)&total;
+    int available = b.getAvailableCopies(); bind[6].buffer_type = MYSQL_TYPE_LONG; bind[6].buffer = (char*)&available;
+
+    if (mysql_stmt_bind_param(stmt, bind) != 0) { cerr << "bind failed: " << mysql_stmt_error(stmt) << endl; return false; }
+    if (mysql_stmt_execute(stmt) != 0) { cerr << "execute failed: " << mysql_stmt_error(stmt) << endl; return false; }
+    return true;
+}
+} // namespace
+#endif
+
 db::DBManager::DBManager() : impl(make_unique<Impl>()) {}
 
 db::DBManager::~DBManager() { disconnect(); }
@@ -174,49 +213,14 @@ bool db::DBManager::createSchema() {
 #endif
 }
 
-bool db::DBManager::saveBooks(const vector<Book>& books) {
+bool db::DBManager::saveBooks(const BookStore& books) {
 #ifdef USE_MYSQL
     if (!impl->conn) return false;
     // Use prepared statement for REPLACE INTO books
-    const char* stmt_sql = "REPLACE INTO books (id,title,author,isbn,category,total,available) VALUES (?,?,?,?,?,?,?)";
-    MYSQL_STMT* stmt = mysql_stmt_init(impl->conn);
-    if (!stmt) { cerr << "mysql_stmt_init failed: " << mysql_error(impl->conn) << endl; return false; }
-    if (mysql_stmt_prepare(stmt, stmt_sql, strlen(stmt_sql)) != 0) {
-        cerr << "prepare failed: " << mysql_stmt_error(stmt) << endl;
-        mysql_stmt_close(stmt);
-        return false;
-    }
-
+    MYSQL_STMT* stmt = prepareStatement(impl->conn, kReplaceBookSql);
+    if (!stmt) return false;
     for (const auto& b : books) {
-        MYSQL_BIND bind[7]; memset(bind, 0, sizeof(bind));
-        // id
-        int id = b.getBookId();
-        bind[0].buffer_type = MYSQL_TYPE_LONG;
-        bind[0].buffer = (char*)&id;
-        // title
-        string title = b.getTitle();
-        bind[1].buffer_type = MYSQL_TYPE_STRING; bind[1].buffer = (char*)title.c_str(); bind[1].buffer_length = title.size();
-        // author
-        string author = b.getAuthor();
-        bind[2].buffer_type = MYSQL_TYPE_STRING; bind[2].buffer = (char*)author.c_str(); bind[2].buffer_length = author.size();
-        // isbn
-        string isbn = b.getIsbn();
-        bind[3].buffer_type = MYSQL_TYPE_STRING; bind[3].buffer = (char*)isbn.c_str(); bind[3].buffer_length = isbn.size();
-        // category
-        string category = b.getCategory();
-        bind[4].buffer_type = MYSQL_TYPE_STRING; bind[4].buffer = (char*)category.c_str(); bind[4].buffer_length = category.size();
-        // total
-        int total = b.getTotalCopies(); bind[5].buffer_type = MYSQL_TYPE_LONG; bind[5].buffer = (char*)&total;
-        // available
-        int available = b.getAvailableCopies(); bind[6].buffer_type = MYSQL_TYPE_LONG; bind[6].buffer = (char*)&available;
-
-        if (mysql_stmt_bind_param(stmt, bind) != 0) {
-            cerr << "bind failed: " << mysql_stmt_error(stmt) << endl;
-            mysql_stmt_close(stmt);
-            return false;
-        }
-        if (mysql_stmt_execute(stmt) != 0) {
-            cerr << "execute failed: " << mysql_stmt_error(stmt) << endl;
+        if (!executeBookReplace(stmt, b)) {
             mysql_stmt_close(stmt);
             return false;
         }
@@ -248,10 +252,12 @@ bool db::DBManager::loadBooks(vector<Book>& outBooks) {
         string category = row[4] ? row[4] : "";
         int total = row[5] ? atoi(row[5]) : 0;
         int available = row[6] ? atoi(row[6]) : total;
-        Book b(id, title, author, isbn, category, total);
-        int borrowCount = total - available;
-        for (int i=0;i<borrowCount;i++) b.borrowBook();
-        outBooks.push_back(b);
+        auto b = Book::withCounts(id, title, author, isbn, category, total, available);
+        if (!b) {
+            cerr << "loadBooks: skipping book " << id << " with invalid copy counts" << endl;
+            continue;
+        }
+        outBooks.push_back(std::move(*b));
     }
     mysql_free_result(res);
     return true;
@@ -261,7 +267,7 @@ bool db::DBManager::loadBooks(vector<Book>& outBooks) {
 #endif
 }
 
-bool db::DBManager::saveBorrowers(const vector<Borrower*>& borrowers) {
+bool db::DBManager::saveBorrowers(const vector<unique_ptr<Borrower>>& borrowers) {
 #ifdef USE_MYSQL
     if (!impl->conn) return false;
     const char* stmt_sql = "REPLACE INTO borrowers (id,type,name,department,max_limit,extra) VALUES (?,?,?,?,?,?)";
@@ -269,21 +275,21 @@ bool db::DBManager::saveBorrowers(const vector<Borrower*>& borrowers) {
     if (!stmt) { cerr << "mysql_stmt_init failed: " << mysql_error(impl->conn) << endl; return false; }
     if (mysql_stmt_prepare(stmt, stmt_sql, strlen(stmt_sql)) != 0) { cerr << "prepare failed: " << mysql_stmt_error(stmt) << endl; mysql_stmt_close(stmt); return false; }
 
-    for (auto b : borrowers) {
+    for (const auto& b : borrowers) {
         string type = b->getType();
-        string extra;
-        Student* s = dynamic_cast<Student*>(b);
+        string_view extra = ""; // 指向字面量，避免空 string_view 的 data() 为 nullptr
+        Student* s = dynamic_cast<Student*>(b.get());
         if (s) extra = s->getMajor();
-        Teacher* t = dynamic_cast<Teacher*>(b);
+        Teacher* t = dynamic_cast<Teacher*>(b.get());
         if (t) extra = t->getTitle();
 
         MYSQL_BIND bind[6]; memset(bind, 0, sizeof(bind));
-        string id = b->getId(); bind[0].buffer_type = MYSQL_TYPE_STRING; bind[0].buffer = (char*)id.c_str(); bind[0].buffer_length = id.size();
+        const string& id = b->getId(); bind[0].buffer_type = MYSQL_TYPE_STRING; bind[0].buffer = (char*)id.c_str(); bind[0].buffer_length = id.size();
         bind[1].buffer_type = MYSQL_TYPE_STRING; bind[1].buffer = (char*)type.c_str(); bind[1].buffer_length = type.size();
-        string name = b->getName(); bind[2].buffer_type = MYSQL_TYPE_STRING; bind[2].buffer = (char*)name.c_str(); bind[2].buffer_length = name.size();
-        string dept = b->getDepartment(); bind[3].buffer_type = MYSQL_TYPE_STRING; bind[3].buffer = (char*)dept.c_str(); bind[3].buffer_length = dept.size();
+        const string& name = b->getName(); bind[2].buffer_type = MYSQL_TYPE_STRING; bind[2].buffer = (char*)name.c_str(); bind[2].buffer_length = name.size();
+        const string& dept = b->getDepartment(); bind[3].buffer_type = MYSQL_TYPE_STRING; bind[3].buffer = (char*)dept.c_str(); bind[3].buffer_length = dept.size();
         int limit = b->getMaxBorrowLimit(); bind[4].buffer_type = MYSQL_TYPE_LONG; bind[4].buffer = (char*)&limit;
-        bind[5].buffer_type = MYSQL_TYPE_STRING; bind[5].buffer = (char*)extra.c_str(); bind[5].buffer_length = extra.size();
+        bind[5].buffer_type = MYSQL_TYPE_STRING; bind[5].buffer = (char*)extra.data(); bind[5].buffer_length = extra.size();
 
         if (mysql_stmt_bind_param(stmt, bind) != 0) { cerr << "bind failed: " << mysql_stmt_error(stmt) << endl; mysql_stmt_close(stmt); return false; }
         if (mysql_stmt_execute(stmt) != 0) { cerr << "execute failed: " << mysql_stmt_error(stmt) << endl; mysql_stmt_close(stmt); return false; }
@@ -296,7 +302,7 @@ bool db::DBManager::saveBorrowers(const vector<Borrower*>& borrowers) {
 #endif
 }
 
-bool db::DBManager::loadBorrowers(vector<Borrower*>& outBorrowers) {
+bool db::DBManager::loadBorrowers(vector<unique_ptr<Borrower>>& outBorrowers) {
 #ifdef USE_MYSQL
     if (!impl->conn) return false;
     if (mysql_query(impl->conn, "SELECT id,type,name,department,max_limit,extra FROM borrowers") != 0) {
@@ -306,7 +312,6 @@ bool db::DBManager::loadBorrowers(vector<Borrower*>& outBorrowers) {
     MYSQL_RES* res = mysql_store_result(impl->conn);
     if (!res) return false;
     MYSQL_ROW row;
-    for (auto b : outBorrowers) delete b;
     outBorrowers.clear();
     while ((row = mysql_fetch_row(res))) {
         string id = row[0] ? row[0] : "";
@@ -323,7 +328,7 @@ bool db::DBManager::loadBorrowers(vector<Borrower*>& outBorrowers) {
         } else {
             continue;
         }
-        outBorrowers.push_back(br);
+        outBorrowers.emplace_back(br);
     }
     mysql_free_result(res);
     return true;
@@ -1009,25 +1014,29 @@ bool db::DBManager::getAllUsers(vector<map<string, string>>& outUsers) {
 bool db::DBManager::upsertBook(const Book& book) {
 #ifdef USE_MYSQL
     if (!impl->conn) return false;
-    const char* stmt_sql = "REPLACE INTO books (id,title,author,isbn,category,total,available) VALUES (?,?,?,?,?,?,?)";
-    MYSQL_STMT* stmt = mysql_stmt_init(impl->conn);
-    if (!stmt) { cerr << "mysql_stmt_init failed: " << mysql_error(impl->conn) << endl; return false; }
-    if (mysql_stmt_prepare(stmt, stmt_sql, strlen(stmt_sql)) != 0) {
-        cerr << "prepare failed: " << mysql_stmt_error(stmt) << endl; mysql_stmt_close(stmt); return false; }
-
-    MYSQL_BIND bind[7]; memset(bind, 0, sizeof(bind));
-    int id = book.getBookId(); bind[0].buffer_type = MYSQL_TYPE_LONG; bind[0].buffer = (char*)&id;
-    string title = book.getTitle(); bind[1].buffer_type = MYSQL_TYPE_STRING; bind[1].buffer = (char*)title.c_str(); bind[1].buffer_length = title.size();
-    string author = book.getAuthor(); bind[2].buffer_type = MYSQL_TYPE_STRING; bind[2].buffer = (char*)author.c_str(); bind[2].buffer_length = author.size();
-    string isbn = book.getIsbn(); bind[3].buffer_type = MYSQL_TYPE_STRING; bind[3].buffer = (char*)isbn.c_str(); bind[3].buffer_length = isbn.size();
-    string category = book.getCategory(); bind[4].buffer_type = MYSQL_TYPE_STRING; bind[4].buffer = (char*)category.c_str(); bind[4].buffer_length = category.size();
-    int total = book.getTotalCopies(); bind[5].buffer_type = MYSQL_TYPE_LONG; bind[5].buffer = (char*)&total;
-    int available = book.getAvailableCopies(); bind[6].buffer_type = MYSQL_TYPE_LONG; bind[6].buffer = (char*)&available;
+    MYSQL_STMT* stmt = prepareStatement(impl->conn, kReplaceBookSql);
+    if (!stmt) return false;
+    bool ok = executeBookReplace(stmt, book);
+    mysql_stmt_close(stmt);
+    return ok;
+#else
+    cerr << "MySQL support not enabled." << endl;
+    return false;
+#endif
+}
 
-    if (mysql_stmt_bind_param(stmt, bind) != 0) { cerr << "bind failed: " << mysql_stmt_error(stmt) << endl; mysql_stmt_close(stmt); return false; }
-    if (mysql_stmt_execute(stmt) != 0) { cerr << "execute failed: " << mysql_stmt_error(stmt) << endl; mysql_stmt_close(stmt); return false; }
+bool db::DBManager::upsertBooks(const vector<const Book*>& books) {
+#ifdef USE_MYSQL
+    if (!impl->conn) return false;
+    if (books.empty()) return true;
+    MYSQL_STMT* stmt = prepareStatement(impl->conn, kReplaceBookSql);
+    if (!stmt) return false;
+    bool ok = true;
+    for (const Book* book : books) {
+        if (!(ok = executeBookReplace(stmt, *book))) break;
+    }
     mysql_stmt_close(stmt);
-    return true;
+    return ok;
 #else
     cerr << "MySQL support not enabled." << endl;
     return false;
@@ -1062,19 +1071,19 @@ bool db::DBManager::upsertBorrower(Borrower* borrower) {
     if (mysql_stmt_prepare(stmt, stmt_sql, strlen(stmt_sql)) != 0) { cerr << "prepare failed: " << mysql_stmt_error(stmt) << endl; mysql_stmt_close(stmt); return false; }
 
     string type = borrower->getType();
-    string extra;
+    string_view extra = "";
     Student* s = dynamic_cast<Student*>(borrower);
     if (s) extra = s->getMajor();
     Teacher* t = dynamic_cast<Teacher*>(borrower);
     if (t) extra = t->getTitle();
 
     MYSQL_BIND bind[6]; memset(bind, 0, sizeof(bind));
-    string id = borrower->getId(); bind[0].buffer_type = MYSQL_TYPE_STRING; bind[0].buffer = (char*)id.c_str(); bind[0].buffer_length = id.size();
+    const string& id = borrower->getId(); bind[0].buffer_type = MYSQL_TYPE_STRING; bind[0].buffer = (char*)id.c_str(); bind[0].buffer_length = id.size();
     bind[1].buffer_type = MYSQL_TYPE_STRING; bind[1].buffer = (char*)type.c_str(); bind[1].buffer_length = type.size();
-    string name = borrower->getName(); bind[2].buffer_type = MYSQL_TYPE_STRING; bind[2].buffer = (char*)name.c_str(); bind[2].buffer_length = name.size();
-    string dept = borrower->getDepartment(); bind[3].buffer_type = MYSQL_TYPE_STRING; bind[3].buffer = (char*)dept.c_str(); bind[3].buffer_length = dept.size();
+    const string& name = borrower->getName(); bind[2].buffer_type = MYSQL_TYPE_STRING; bind[2].buffer = (char*)name.c_str(); bind[2].buffer_length = name.size();
+    const string& dept = borrower->getDepartment(); bind[3].buffer_type = MYSQL_TYPE_STRING; bind[3].buffer = (char*)dept.c_str(); bind[3].buffer_length = dept.size();
     int limit = borrower->getMaxBorrowLimit(); bind[4].buffer_type = MYSQL_TYPE_LONG; bind[4].buffer = (char*)&limit;
-    bind[5].buffer_type = MYSQL_TYPE_STRING; bind[5].buffer = (char*)extra.c_str(); bind[5].buffer_length = extra.size();
+    bind[5].buffer_type = MYSQL_TYPE_STRING; bind[5].buffer = (char*)extra.data(); bind[5].buffer_length = extra.size();
 
     if (mysql_stmt_bind_param(stmt, bind) != 0) { cerr << "bind failed: " << mysql_stmt_error(stmt) << endl; mysql_stmt_close(stmt); return false; }
     if (mysql_stmt_execute(stmt) != 0) { cerr << "execute failed: " << mysql_stmt_error(stmt) << endl; mysql_stmt_close(stmt); return false; }
@@ -1104,3 +1113,54 @@ bool db::DBManager::removeBorrower(const string& borrowerId) {
     return false;
 #endif
 }
+
+bool db::DBManager::saveChanges(Library& library, const LibraryChangeSet& changes) {
+#ifdef USE_MYSQL
+    if (!impl->conn) return false;
+    if (changes.empty()) return true;
+    // 先在共享锁下复制要写出的行，事务期间其他线程可以继续增删而不影响这些副本；
+    // 记录与复制之间被删除的条目跳过，其删除已记入下一批修改
+    vector<Book> bookRows;
+    vector<unique_ptr<Borrower>> borrowerRows;
+    library.copyChangedRows(changes, bookRows, borrowerRows);
+    vector<const Book*> changedBooks;
+    changedBooks.reserve(bookRows.size());
+    for (const Book& book : bookRows) changedBooks.push_back(&book);
+
+    mysql_autocommit(impl->conn, false);
+    bool ok = true;
+    for (int bookId : changes.removedBooks) ok = ok && removeBook(bookId);
+    for (const auto& borrowerId : changes.removedBorrowers) ok = ok && removeBorrower(borrowerId);
+    ok = ok && upsertBooks(changedBooks);
+    for (const auto& borrower : borrowerRows) {
+        if (!ok) break;
+        ok = upsertBorrower(borrower.get());
+    }
+    if (ok && mysql_commit(impl->conn) != 0) {
+        cerr << "commit failed: " << mysql_error(impl->conn) << endl;
+        ok = false;
+    }
+    if (!ok) mysql_rollback(impl->conn);
+    mysql_autocommit(impl->conn, true);
+    return ok;
+#else
+    cerr << "MySQL support not enabled." << endl;
+    return false;
+#endif
+}
+
+size_t db::restoreOutstandingLoans(Library& library, const vector<map<string, string>>& records) {
+    size_t restored = 0;
+    for (const auto& record : records) {
+        auto status = record.find("status");
+        auto bookId = record.find("book_id");
+        auto borrowerId = record.find("borrower_id");
+        if (status == record.end() || status->second != "borrowed") continue;
+        if (bookId == record.end() || borrowerId == record.end()) continue;
+        int id = atoi(bookId->second.c_str());
+        if (library.assignOutstandingLoan(borrowerId->second, id) == LoanResult::Ok) {
+            ++restored;
+        }
+    }
+    return restored;
+}
@@ -6,7 +6,10 @@
 using namespace std;
 // Forward declarations
 class Book;
+class BookStore;
 class Borrower;
+class Library;
+struct LibraryChangeSet;
 
 namespace db {
 
@@ -22,19 +25,24 @@ namespace db {
 
         bool createSchema();
 
-        bool saveBooks(const vector<Book>& books);
+        bool saveBooks(const BookStore& books);
         bool loadBooks(vector<Book>& outBooks);
 
         // single-object operations
         bool upsertBook(const Book& book);
+        // 批量 REPLACE：整批共用一个预处理语句；不单独开启事务，由调用方决定（如 saveChanges）
+        bool upsertBooks(const vector<const Book*>& books);
         bool removeBook(int bookId);
 
-        bool saveBorrowers(const vector<Borrower*>& borrowers);
-        bool loadBorrowers(vector<Borrower*>& outBorrowers);
+        bool saveBorrowers(const vector<unique_ptr<Borrower>>& borrowers);
+        bool loadBorrowers(vector<unique_ptr<Borrower>>& outBorrowers);
 
         bool upsertBorrower(Borrower* borrower);
         bool removeBorrower(const string& borrowerId);
 
+        // 只写出修改记录中的行：先删除已删除的图书/借阅人，再 REPLACE 有修改的行，在一个事务内完成
+        bool saveChanges(Library& library, const LibraryChangeSet& changes);
+
         // Borrow records management
         bool createBorrowRecord(const string& borrowerId, int bookId, int borrowDays);
         bool returnBorrowRecord(int bookId, const string& borrowerId);
@@ -60,4 +68,8 @@ namespace db {
         unique_ptr<Impl> impl;
     };
 
+    // 把借阅记录中未归还（status = borrowed）的条目经 Library::assignOutstandingLoan
+    // 归属到借阅人名下；图书副本数已由 books 表恢复，不会重复扣减。返回成功归属的条数
+    size_t restoreOutstandingLoans(Library& library, const vector<map<string, string>>& records);
+
 } // namespace db
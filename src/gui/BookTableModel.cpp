@@ -6,25 +6,24 @@
 BookTableModel::BookTableModel(LibraryController* ctrl, QObject* parent)
     : QAbstractTableModel(parent), controller(ctrl), useFiltered(false) {
     refresh();
-    // connect controller signal to refresh the model when library changes
+    // 只有整库重新加载时才重建缓存，其余变更按行增量更新
     if (controller) {
-        QObject::connect(controller, &LibraryController::libraryChanged, [this]() {
-            this->refresh();
-        });
+        QObject::connect(controller, &LibraryController::catalogueReset, this, &BookTableModel::refresh);
+        QObject::connect(controller, &LibraryController::bookAdded, this, &BookTableModel::handleBookAdded);
+        QObject::connect(controller, &LibraryController::bookRemoved, this, &BookTableModel::handleBookRemoved);
+        QObject::connect(controller, &LibraryController::bookChanged, this, &BookTableModel::handleBookChanged);
     }
 }
 
 int BookTableModel::rowCount(const QModelIndex &/*parent*/) const { 
-    return useFiltered ? (int)filteredCache.size() : (int)booksCache.size(); 
+    return (int)activeCache().size(); 
 }
 int BookTableModel::columnCount(const QModelIndex &/*parent*/) const { return 6; }
 
 QVariant BookTableModel::data(const QModelIndex &index, int role) const {
     if (!index.isValid()) return {};
     
-    const std::vector<Book*>& cache = useFiltered ? filteredCache : booksCache;
-    if (index.row() < 0 || index.row() >= (int)cache.size()) return {};
-    Book* b = cache[index.row()];
+    const Book* b = bookAt(index.row());
     if (!b) return {};
 
     if (role == Qt::DisplayRole) {
@@ -58,8 +57,8 @@ QVariant BookTableModel::headerData(int section, Qt::Orientation orientation, in
 }
 
 int BookTableModel::bookIdAtRow(int row) const { 
-    const std::vector<Book*>& cache = useFiltered ? filteredCache : booksCache;
-    return (row>=0 && row<(int)cache.size())? cache[row]->getBookId() : -1; 
+    const std::vector<Row>& cache = activeCache();
+    return (row>=0 && row<(int)cache.size())? cache[row].bookId : -1; 
 }
 
 void BookTableModel::refresh() {
@@ -67,14 +66,68 @@ void BookTableModel::refresh() {
     booksCache.clear();
     filteredCache.clear();
     useFiltered = false;
-    auto books = controller->allBooks();
-    for (auto b : books) booksCache.push_back(b);
+    auto handles = controller->allBookHandles();
+    booksCache.reserve(handles.size());
+    for (const auto& handle : handles) {
+        const Book* b = controller->resolve(handle);
+        if (b) booksCache.push_back({handle, b->getBookId()});
+    }
     endResetModel();
 }
 
 void BookTableModel::setFilteredBooks(const std::vector<Book*>& filtered) {
     beginResetModel();
-    filteredCache = filtered;
+    filteredCache.clear();
+    filteredCache.reserve(filtered.size());
+    for (auto b : filtered) {
+        if (b) filteredCache.push_back({controller->handleOf(b->getBookId()), b->getBookId()});
+    }
     useFiltered = true;
     endResetModel();
 }
+
+const Book* BookTableModel::bookAt(int row) const {
+    const std::vector<Row>& cache = activeCache();
+    if (row < 0 || row >= (int)cache.size()) return nullptr;
+    return controller->resolve(cache[row].handle);
+}
+
+int BookTableModel::rowOf(const std::vector<Row>& cache, int bookId) const {
+    for (int row = 0; row < (int)cache.size(); ++row) {
+        if (cache[row].bookId == bookId) return row;
+    }
+    return -1;
+}
+
+void BookTableModel::handleBookAdded(int bookId) {
+    BookHandle handle = controller->handleOf(bookId);
+    if (handle.isNull()) return;
+    // 过滤视图保持用户的搜索结果不变，新书只进入完整列表
+    if (!useFiltered) {
+        int row = (int)booksCache.size();
+        beginInsertRows(QModelIndex(), row, row);
+        booksCache.push_back({handle, bookId});
+        endInsertRows();
+    } else {
+        booksCache.push_back({handle, bookId});
+    }
+}
+
+void BookTableModel::handleBookRemoved(int bookId) {
+    auto removeFrom = [this, bookId](std::vector<Row>& cache, bool visible) {
+        int row = rowOf(cache, bookId);
+        if (row < 0) return;
+        if (visible) beginRemoveRows(QModelIndex(), row, row);
+        cache.erase(cache.begin() + row);
+        if (visible) endRemoveRows();
+    };
+    removeFrom(booksCache, !useFiltered);
+    removeFrom(filteredCache, useFiltered);
+}
+
+void BookTableModel::handleBookChanged(int bookId) {
+    int row = rowOf(activeCache(), bookId);
+    if (row >= 0) {
+        emit dataChanged(index(row, 0), index(row, columnCount() - 1));
+    }
+}
@@ -1,7 +1,10 @@
 #pragma once
 #include <QAbstractTableModel>
+#include <unordered_map>
 #include <vector>
 
+#include "BookStore.h"
+
 class LibraryController;
 class Book;
 
@@ -19,8 +22,21 @@ public:
     void setFilteredBooks(const std::vector<Book*>& filtered);
 
 private:
+    struct Row {
+        BookHandle handle; // generation-checked, survives catalogue growth
+        int bookId;
+    };
+
     LibraryController* controller;
-    std::vector<Book*> booksCache; // cache pointers to Library's internal Book objects
+    std::vector<Row> booksCache;
     bool useFiltered;
-    std::vector<Book*> filteredCache;
+    std::vector<Row> filteredCache;
+
+    const std::vector<Row>& activeCache() const { return useFiltered ? filteredCache : booksCache; }
+    const Book* bookAt(int row) const;
+    int rowOf(const std::vector<Row>& cache, int bookId) const;
+
+    void handleBookAdded(int bookId);
+    void handleBookRemoved(int bookId);
+    void handleBookChanged(int bookId);
 };
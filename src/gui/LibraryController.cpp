@@ -2,11 +2,13 @@
 #include "Library.h"
 #include "Book.h"
 #include "FileManager.h"
+#include "Student.h"
 #include "src/db/DBManager.h"
 #include <algorithm>
 #include <cstdlib>
 #include <iostream>
 #include <map>
+#include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
@@ -35,7 +37,7 @@ LibraryController::LibraryController(QObject* /*parent*/) {
 }
 
 LibraryController::~LibraryController() { 
-    // Save to database before destruction
+    // 每次修改后已写出修改记录，这里只补写写出失败而放回的部分
     if (dbManager && dbManager->isConnected()) {
         saveToDatabase();
     }
@@ -89,6 +91,7 @@ void LibraryController::initializeDatabase() {
 
 std::vector<Book*> LibraryController::allBooks() {
     std::vector<Book*> res;
+    res.reserve(lib->getBooks().size());
     // Return pointers to internal Book objects to avoid copies. Caller must NOT delete these pointers.
     for (auto &b : lib->getBooks()) {
         res.push_back(&b);
@@ -96,23 +99,40 @@ std::vector<Book*> LibraryController::allBooks() {
     return res;
 }
 
-Book* LibraryController::getBookById(int id) {
-    for (auto &b : lib->getBooks()) {
-        if (b.getBookId() == id) return &b;
+std::vector<BookHandle> LibraryController::allBookHandles() const {
+    std::vector<BookHandle> res;
+    const BookStore& books = lib->getBooks();
+    res.reserve(books.size());
+    for (auto it = books.begin(); it != books.end(); ++it) {
+        res.push_back(books.handleAt(it.slotIndex()));
     }
-    return nullptr;
+    return res;
+}
+
+BookHandle LibraryController::handleOf(int id) const {
+    return lib->handleOf(id);
+}
+
+Book* LibraryController::resolve(BookHandle handle) {
+    return lib->resolve(handle);
+}
+
+Book* LibraryController::getBookById(int id) {
+    return lib->findBookById(id);
+}
+
+std::vector<CategoryStats> LibraryController::categoryHistogram() const {
+    return lib->categoryHistogram();
 }
 
 std::vector<Book> LibraryController::recommendBooks(int limit) {
     std::vector<Book> recommendations;
-    std::vector<Book*> allBooks = this->allBooks();
-    
-    if (allBooks.empty()) {
+    if (limit <= 0) {
         return recommendations;
     }
     
     // 计算每本书的借阅次数（受欢迎程度）
-    std::map<int, int> bookBorrowCount;
+    std::unordered_map<int, int> bookBorrowCount;
     
     // 如果有数据库连接，从借阅记录中获取借阅统计
     if (dbManager && dbManager->isConnected()) {
@@ -128,138 +148,107 @@ std::vector<Book> LibraryController::recommendBooks(int limit) {
         }
     }
     
-    // 创建带评分的书籍列表
+    // 创建带评分的书籍列表：只读取数值列，不触碰完整的 Book 对象
     struct BookScore {
-        Book* book;
+        std::size_t slot;
         int score;
+        bool available;
     };
     
+    // 扫描期间持有共享锁，防止导入或数据库同步增删图书时块数组变化；借还仍可并发，可借数按原子量读取
+    auto readLock = lib->readLock();
+    const BookStore& books = lib->getBooks();
+    if (books.empty()) {
+        return recommendations;
+    }
     std::vector<BookScore> scoredBooks;
-    for (Book* book : allBooks) {
-        int score = 0;
-        
-        // 基础分数：可借数量越多，分数越高
-        score += book->getAvailableCopies() * 10;
-        
-        // 受欢迎程度：借阅次数越多，分数越高
-        score += bookBorrowCount[book->getBookId()] * 5;
-        
-        // 如果可借，额外加分
-        if (book->getIsAvailable()) {
-            score += 20;
+    scoredBooks.reserve(books.size());
+    for (std::size_t chunk = 0; chunk < books.chunkCount(); ++chunk) {
+        const BookStore::CountColumns columns = books.columns(chunk);
+        for (std::size_t i = 0; i < columns.size; ++i) {
+            const std::size_t slot = columns.firstSlot + i;
+            if (!books.isLive(slot)) continue;
+            
+            const int available = columns.available(i);
+            // 基础分数：可借数量越多，分数越高
+            int score = available * 10;
+            
+            // 受欢迎程度：借阅次数越多，分数越高
+            if (!bookBorrowCount.empty()) {
+                auto it = bookBorrowCount.find(columns.id(i));
+                if (it != bookBorrowCount.end()) score += it->second * 5;
+            }
+            
+            // 如果可借，额外加分
+            if (available > 0) {
+                score += 20;
+            }
+            
+            scoredBooks.push_back({slot, score, available > 0});
         }
-        
-        scoredBooks.push_back({book, score});
     }
     
-    // 按分数降序排序
-    std::sort(scoredBooks.begin(), scoredBooks.end(), 
+    // 优先选择可借的书籍，其次按分数降序；只需排出前 limit 名
+    const std::size_t count = std::min(static_cast<std::size_t>(limit), scoredBooks.size());
+    std::partial_sort(scoredBooks.begin(), scoredBooks.begin() + count, scoredBooks.end(),
               [](const BookScore& a, const BookScore& b) {
+                  if (a.available != b.available) return a.available;
                   return a.score > b.score;
               });
     
-    // 优先选择可借的书籍，然后选择其他书籍
-    std::vector<Book> availableBooks;
-    std::vector<Book> otherBooks;
-    
-    for (const auto& item : scoredBooks) {
-        if (item.book->getIsAvailable()) {
-            availableBooks.push_back(*item.book);
-        } else {
-            otherBooks.push_back(*item.book);
-        }
-    }
-    
-    // 先添加可借书籍，再添加其他书籍，直到达到限制
-    int count = 0;
-    for (const auto& book : availableBooks) {
-        if (count >= limit) break;
-        recommendations.push_back(book);
-        count++;
-    }
-    
-    for (const auto& book : otherBooks) {
-        if (count >= limit) break;
-        recommendations.push_back(book);
-        count++;
+    recommendations.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        recommendations.push_back(books.at(scoredBooks[i].slot));
     }
     
     return recommendations;
 }
 
-bool LibraryController::borrowBook(int id, const std::string& borrowerId, int borrowDays) {
-    bool ok = lib->lendBook(id);
-    if (ok) {
-        if (dbManager && dbManager->isConnected()) {
-            Book* book = lib->findBookById(id);
-            if (book) {
-                dbManager->upsertBook(*book);
-                // Create borrow record
-                dbManager->createBorrowRecord(borrowerId, id, borrowDays);
-            }
-        }
-        emit libraryChanged();
+LoanResult LibraryController::borrowBook(int id, const std::string& borrowerId, int borrowDays) {
+    if (!borrowerId.empty() && !lib->findBorrowerById(borrowerId)) {
+        // 仅有登录账号、没有借阅人档案的用户按访客学生登记
+        addBorrower(std::make_unique<Student>(borrowerId, borrowerId, "访客", "", 5));
     }
-    return ok;
-}
-
-bool LibraryController::returnBook(int id, const std::string& borrowerId) {
-    // 先检查数据库中是否有该借阅记录
+    LoanResult result = lib->checkout(borrowerId, id, borrowDays);
+    if (result != LoanResult::Ok) {
+        return result;
+    }
+    saveToDatabase();
     if (dbManager && dbManager->isConnected()) {
-        std::vector<std::map<std::string, std::string>> records;
-        if (dbManager->getActiveBorrowRecordsByBorrower(borrowerId, records)) {
-            bool hasRecord = false;
-            for (const auto& record : records) {
-                if (record.find("book_id") != record.end()) {
-                    try {
-                        if (std::stoi(record.at("book_id")) == id) {
-                            hasRecord = true;
-                            break;
-                        }
-                    } catch (...) {
-                        // 转换失败，继续检查下一条
-                        continue;
-                    }
-                }
-            }
-            if (!hasRecord) {
-                return false; // 该用户没有借阅过这本书
-            }
-        }
+        dbManager->createBorrowRecord(borrowerId, id, borrowDays);
     }
-    
-    // 更新数据库记录
-    bool dbOk = false;
-        if (dbManager && dbManager->isConnected()) {
-        dbOk = dbManager->returnBorrowRecord(id, borrowerId);
-        if (dbOk) {
-            // 更新图书状态
-            Book* book = lib->findBookById(id);
-            if (book) {
-                dbManager->upsertBook(*book);
-            }
-        }
+    emit bookChanged(id);
+    emit libraryChanged();
+    return result;
+}
+
+LoanResult LibraryController::returnBook(int id, const std::string& borrowerId) {
+    LoanResult result = lib->checkin(borrowerId, id);
+    if (result != LoanResult::Ok) {
+        return result;
     }
-    
-    // 更新内存中的图书状态
-    bool ok = lib->receiveBook(id);
-    
-    if (ok || dbOk) {
-        emit libraryChanged();
-        return true;
+    if (dbManager && dbManager->isConnected()) {
+        dbManager->returnBorrowRecord(id, borrowerId);
     }
-    return false;
+    saveToDatabase();
+    emit bookChanged(id);
+    emit libraryChanged();
+    return result;
 }
 
 void LibraryController::loadFromFiles() {
     std::vector<Book> books;
     FileManager::loadBooksFromFile(books, "books.json");
     lib->setBooks(books);
+    emit catalogueReset();
     emit libraryChanged();
 }
 
 void LibraryController::saveToFiles() {
-    FileManager::saveBooksToFile(lib->getBooks(), "books.json");
+    {
+        auto readLock = lib->readLock(); // 写出期间阻止其他线程增删图书
+        FileManager::saveBooksToFile(lib->getBooks(), "books.json");
+    }
     emit libraryChanged();
 }
 
@@ -269,17 +258,23 @@ void LibraryController::loadFromDatabase() {
     }
     
     std::vector<Book> books;
-    std::vector<Borrower*> borrowers;
+    std::vector<std::unique_ptr<Borrower>> borrowers;
     
     if (dbManager->loadBooks(books)) {
         lib->setBooks(books);
     }
     
     if (dbManager->loadBorrowers(borrowers)) {
-        lib->setBorrowers(borrowers);
+        lib->setBorrowers(std::move(borrowers));
+    }
+    
+    // 未归还的借阅记录重新归属到借阅人，之后还书只需走 Library::checkin
+    std::vector<std::map<std::string, std::string>> records;
+    if (dbManager->getAllBorrowRecords(records)) {
+        db::restoreOutstandingLoans(*lib, records);
     }
     
-    lib->updateStatistics();
+    emit catalogueReset();
     emit libraryChanged();
 }
 
@@ -289,8 +284,11 @@ void LibraryController::ensureBaselineBooks() {
     }
     
     std::unordered_set<int> existingIds;
-    for (const auto& book : lib->getBooks()) {
-        existingIds.insert(book.getBookId());
+    {
+        auto readLock = lib->readLock();
+        for (const auto& book : lib->getBooks()) {
+            existingIds.insert(book.getBookId());
+        }
     }
     
     Library seedLibrary("Baseline", "default");
@@ -314,45 +312,78 @@ void LibraryController::saveToDatabase() {
         return;
     }
     
-    dbManager->saveBooks(lib->getBooks());
-    dbManager->saveBorrowers(lib->getBorrowers());
+    // 只写出自上次保存以来修改过的行；载入的数据本身不计为修改
+    LibraryChangeSet changes = lib->takeChanges();
+    if (changes.empty()) {
+        return;
+    }
+    if (!dbManager->saveChanges(*lib, changes)) {
+        lib->restoreChanges(changes);
+    }
 }
 
-void LibraryController::addBook(const Book& book) {
-    lib->addBook(book);
-    if (dbManager && dbManager->isConnected()) {
-        dbManager->upsertBook(book);
+bool LibraryController::addBook(const Book& book) {
+    if (!lib->addBook(book)) {
+        return false;
+    }
+    saveToDatabase();
+    emit bookAdded(book.getBookId());
+    emit libraryChanged();
+    return true;
+}
+
+bool LibraryController::updateBook(int bookId, const Book& updated) {
+    if (!lib->updateBook(bookId, updated)) {
+        return false;
+    }
+    saveToDatabase();
+    if (updated.getBookId() != bookId) {
+        emit bookRemoved(bookId);
+        emit bookAdded(updated.getBookId());
+    } else {
+        emit bookChanged(bookId);
     }
     emit libraryChanged();
+    return true;
+}
+
+BookImporter::Result LibraryController::importBooks(const std::string& filename,
+                                                   const BookImporter::ProgressCallback& progress) {
+    BookImporter importer;
+    BookImporter::Result result = importer.run(filename, [this](const std::vector<Book>& batch) {
+        const std::size_t added = lib->addBooks(batch);
+        saveToDatabase(); // 一批共用一个预处理语句；失败时修改记录保留到下次保存
+        return added;
+    }, progress);
+    if (result.progress.imported > 0) {
+        emit catalogueReset();
+        emit libraryChanged();
+    }
+    return result;
 }
 
 void LibraryController::removeBook(int bookId) {
     if (lib->removeBook(bookId)) {
-        if (dbManager && dbManager->isConnected()) {
-            dbManager->removeBook(bookId);
-        }
+        saveToDatabase();
+        emit bookRemoved(bookId);
         emit libraryChanged();
     }
 }
 
-void LibraryController::addBorrower(Borrower* borrower) {
-    lib->addBorrower(borrower);
-    if (dbManager && dbManager->isConnected()) {
-        dbManager->upsertBorrower(borrower);
+bool LibraryController::addBorrower(std::unique_ptr<Borrower> borrower) {
+    if (!borrower) return false;
+    if (!lib->addBorrower(std::move(borrower))) {
+        return false;
     }
+    saveToDatabase();
     emit libraryChanged();
+    return true;
 }
 
 void LibraryController::removeBorrower(const std::string& borrowerId) {
-    // Check if borrower exists before removal
-    bool existed = (lib->findBorrowerById(borrowerId) != nullptr);
-    lib->removeBorrower(borrowerId);
-    
     // Only update database if borrower was actually removed
-    if (existed) {
-        if (dbManager && dbManager->isConnected()) {
-            dbManager->removeBorrower(borrowerId);
-        }
+    if (lib->removeBorrower(borrowerId)) {
+        saveToDatabase();
         emit libraryChanged();
     }
 }
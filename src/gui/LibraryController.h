@@ -4,8 +4,13 @@
 #include <QObject>
 #include <memory>
 
-class Book;
+#include "BookStore.h"
+#include "BookImporter.h"
+
 class Library;
+class Borrower;
+enum class LoanResult;
+struct CategoryStats;
 
 namespace db {
     class DBManager;
@@ -18,17 +23,27 @@ public:
     ~LibraryController();
 
     std::vector<Book*> allBooks();
+    // 稳定句柄：目录增删后仍可安全 resolve，被删除的图书返回 nullptr
+    std::vector<BookHandle> allBookHandles() const;
+    BookHandle handleOf(int id) const;
+    Book* resolve(BookHandle handle);
     Book* getBookById(int id);
+    std::vector<CategoryStats> categoryHistogram() const;
     std::vector<Book> recommendBooks(int limit = 10);
-    bool borrowBook(int id, const std::string& borrowerId, int borrowDays = 7);
-    bool returnBook(int id, const std::string& borrowerId);
+    // 经 Library::checkout/checkin 借还，成功后同步数据库；登录账号没有对应借阅人时登记为访客
+    LoanResult borrowBook(int id, const std::string& borrowerId, int borrowDays = 7);
+    LoanResult returnBook(int id, const std::string& borrowerId);
     void loadFromFiles(); // deprecated, use loadFromDatabase
     void saveToFiles();   // deprecated, use saveToDatabase
     void loadFromDatabase();
-    void saveToDatabase();
-    void addBook(const Book& book);
+    void saveToDatabase(); // 只写出 Library 修改记录中的行
+    bool addBook(const Book& book); // ID 已存在时返回 false
+    // 原地修改（见 Library::updateBook），在借记录保留；失败时原图书不变
+    bool updateBook(int bookId, const Book& updated);
+    // 流水线批量导入 CSV/TSV；每批写入目录后立即同步数据库，progress 返回 false 时取消
+    BookImporter::Result importBooks(const std::string& filename, const BookImporter::ProgressCallback& progress);
     void removeBook(int bookId);
-    void addBorrower(class Borrower* borrower);
+    bool addBorrower(std::unique_ptr<Borrower> borrower);
     void removeBorrower(const std::string& borrowerId);
     
     bool isDatabaseConnected() const;
@@ -36,6 +51,11 @@ public:
 
 signals:
     void libraryChanged();
+    // 细粒度通知，供表格模型增量更新而不必整表重建
+    void bookAdded(int bookId);
+    void bookRemoved(int bookId);
+    void bookChanged(int bookId);
+    void catalogueReset();
 
 private:
     Library* lib;
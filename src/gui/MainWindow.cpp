@@ -24,9 +24,12 @@
 #include <QPalette>
 #include <QBrush>
 #include <QDate>
+#include <QFileDialog>
+#include <QProgressDialog>
 #include <QScrollArea>
 #include <QSizePolicy>
 #include <algorithm>
+#include <unordered_map>
 #include "BookTableModel.h"
 #include "LibraryController.h"
 #include "AddBookDialog.h"
@@ -39,6 +42,7 @@
 #include "BookDetailDialog.h"
 #include "UsersListDialog.h"
 #include "Book.h"
+#include "Library.h"
 #include "Student.h"
 #include "Teacher.h"
 #include "src/db/DBManager.h"
@@ -288,6 +292,7 @@ void MainWindow::setupUi() {
     editBookAct = new QAction("编辑", this);
     reloadAct = new QAction("刷新", this);
     addBookAct = new QAction("添加", this);
+    importBooksAct = new QAction("批量导入", this);
     removeBookAct = new QAction("删除", this);
     addUserAct = new QAction("添加用户", this);
     resetPasswordAct = new QAction("重置密码", this);
@@ -296,6 +301,7 @@ void MainWindow::setupUi() {
     
     editBookAct->setEnabled(isAdmin);
     addBookAct->setEnabled(isAdmin);
+    importBooksAct->setEnabled(isAdmin);
     removeBookAct->setEnabled(isAdmin);
     addUserAct->setEnabled(isAdmin);
     resetPasswordAct->setEnabled(isAdmin);
@@ -406,6 +412,7 @@ void MainWindow::setupUi() {
     if (isAdmin) {
         if (QWidget* collectionGroup = createActionGroup("馆藏管理", {
                 {addBookAct, neutralActionStyle},
+                {importBooksAct, neutralActionStyle},
                 {editBookAct, neutralActionStyle},
                 {removeBookAct, dangerActionStyle},
                 {bookDetailAct, neutralActionStyle}
@@ -664,13 +671,14 @@ void MainWindow::setupUi() {
         // Use borrower ID from login
         QString borrowerId = currentBorrowerId;
         
-        if (controller->borrowBook(bookId, borrowerId.toStdString(), borrowDays)) {
+        LoanResult result = controller->borrowBook(bookId, borrowerId.toStdString(), borrowDays);
+        if (result == LoanResult::Ok) {
             QMessageBox::information(this, "成功", 
                 QString("成功借阅图书《%1》！\n\n借阅天数: %2天").arg(QString::fromStdString(book->getTitle())).arg(borrowDays));
-            model->refresh();
             updateBookCount();
         } else {
-            QMessageBox::warning(this, "失败", QString(" 借阅图书《%1》失败，请稍后重试！").arg(QString::fromStdString(book->getTitle())));
+            QMessageBox::warning(this, "失败", QString(" 借阅图书《%1》失败：%2").arg(QString::fromStdString(book->getTitle()))
+                .arg(QString::fromUtf8(loanResultMessage(result))));
         }
     });
 
@@ -696,20 +704,19 @@ void MainWindow::setupUi() {
             return;
         }
         
-        if (controller->returnBook(bookId, borrowerId.toStdString())) {
+        LoanResult result = controller->returnBook(bookId, borrowerId.toStdString());
+        if (result == LoanResult::Ok) {
             QMessageBox::information(this, "成功", "归还成功！");
-            model->refresh();
             updateBookCount();
         } else {
             QMessageBox::warning(this, "失败", 
-                QString("归还失败！\n\n可能的原因：\n1. 您未借阅过该图书\n2. 该图书已被归还\n3. 数据库连接失败\n\n借阅人ID: %1\n图书ID: %2")
-                .arg(borrowerId).arg(bookId));
+                QString("归还失败：%1\n\n借阅人ID: %2\n图书ID: %3")
+                .arg(QString::fromUtf8(loanResultMessage(result))).arg(borrowerId).arg(bookId));
         }
     });
 
     connect(reloadAct, &QAction::triggered, [this]() {
         controller->loadFromDatabase();
-        model->refresh();
         updateBookCount();
         QMessageBox::information(this, "刷新完成", "已从数据库重新加载数据！");
     });
@@ -740,18 +747,27 @@ void MainWindow::setupUi() {
                        book->getTotalCopies());
         
         if (dlg.exec() == QDialog::Accepted) {
-            // Remove old book and add updated one
-            controller->removeBook(bookId);
-            Book updatedBook(dlg.getId(), dlg.getTitleStr().toStdString(), 
-                           dlg.getAuthor().toStdString(), dlg.getIsbn().toStdString(),
-                           dlg.getCategory().toStdString(), dlg.getCopies());
-            // Preserve borrow status
-            int borrowedCount = book->getTotalCopies() - book->getAvailableCopies();
-            for (int i = 0; i < borrowedCount && i < dlg.getCopies(); i++) {
-                updatedBook.borrowBook();
+            // 在借副本由 Library::updateBook 保留，这里只做校验并给出具体提示
+            const int borrowedCount = book->getTotalCopies() - book->getAvailableCopies();
+            const int newId = dlg.getId();
+            if (newId != bookId && controller->getBookById(newId)) {
+                QMessageBox::warning(this, "错误", QString("ID 为 %1 的图书已存在！").arg(newId));
+                return;
+            }
+            if (newId != bookId && borrowedCount > 0) {
+                QMessageBox::warning(this, "错误", QString("该书有 %1 本未归还，不能修改 ID！").arg(borrowedCount));
+                return;
+            }
+            if (dlg.getCopies() < borrowedCount) {
+                QMessageBox::warning(this, "错误", QString("该书有 %1 本未归还，总数不能少于此数！").arg(borrowedCount));
+                return;
+            }
+            Book updatedBook(newId, dlg.getTitleStr().toStdString(), dlg.getAuthor().toStdString(),
+                             dlg.getIsbn().toStdString(), dlg.getCategory().toStdString(), dlg.getCopies());
+            if (!controller->updateBook(bookId, updatedBook)) {
+                QMessageBox::warning(this, "错误", "图书信息更新失败！");
+                return;
             }
-            controller->addBook(updatedBook);
-            model->refresh();
             updateBookCount();
             QMessageBox::information(this, "编辑成功", QString("图书《%1》信息已更新！").arg(dlg.getTitleStr()));
         }
@@ -766,13 +782,60 @@ void MainWindow::setupUi() {
         if (dlg.exec() == QDialog::Accepted) {
             Book b(dlg.getId(), dlg.getTitleStr().toStdString(), dlg.getAuthor().toStdString(), 
                    dlg.getIsbn().toStdString(), dlg.getCategory().toStdString(), dlg.getCopies());
-            controller->addBook(b);
-            model->refresh();
+            if (!controller->addBook(b)) {
+                QMessageBox::warning(this, "错误", QString("ID 为 %1 的图书已存在！").arg(dlg.getId()));
+                return;
+            }
             updateBookCount();
             QMessageBox::information(this, "添加成功", QString("图书《%1》已成功添加到图书馆！").arg(dlg.getTitleStr()));
         }
     });
 
+    connect(importBooksAct, &QAction::triggered, [this]() {
+        if (currentUserType != "admin") {
+            QMessageBox::warning(this, "你不配", "此操作需要管理员权限！");
+            return;
+        }
+        QString path = QFileDialog::getOpenFileName(this, "批量导入图书", QString(),
+                                                    "图书数据 (*.csv *.tsv *.txt);;所有文件 (*)");
+        if (path.isEmpty()) {
+            return;
+        }
+        // 导入在后台线程读取与校验，这里按批写入并刷新进度；取消后已写入的批次保留
+        QProgressDialog progressDialog("正在导入图书...", "取消", 0, 100, this);
+        progressDialog.setWindowModality(Qt::WindowModal);
+        progressDialog.setMinimumDuration(300);
+        BookImporter::Result result = controller->importBooks(path.toStdString(),
+            [&progressDialog](const BookImporter::Progress& progress) {
+                if (progress.totalBytes > 0) {
+                    progressDialog.setValue(static_cast<int>(progress.bytesRead * 100 / progress.totalBytes));
+                }
+                progressDialog.setLabelText(QString("已导入 %1 本").arg(progress.imported));
+                QApplication::processEvents();
+                return !progressDialog.wasCanceled();
+            });
+        progressDialog.setValue(100);
+        updateBookCount();
+
+        const BookImporter::Progress& progress = result.progress;
+        QString summary = QString("新增 %1 本，ID 已存在跳过 %2 本，非法记录 %3 条。")
+                              .arg(progress.imported).arg(progress.skipped).arg(progress.rejected);
+        if (result.cancelled) {
+            summary.prepend("导入已取消。");
+        }
+        if (!result.errors.empty()) {
+            summary += "\n";
+            for (const std::string& error : result.errors) {
+                summary += "\n" + QString::fromStdString(error);
+            }
+        }
+        if (result.ok) {
+            QMessageBox::information(this, "导入完成", summary);
+        } else {
+            QMessageBox::warning(this, "导入未完成", summary);
+        }
+    });
+
     connect(removeBookAct, &QAction::triggered, [this]() {
         if (currentUserType != "admin") {
             QMessageBox::warning(this, "你不配", "此操作需要管理员权限！");
@@ -795,7 +858,6 @@ void MainWindow::setupUi() {
         if (reply == QMessageBox::Yes) {
             QString title = QString::fromStdString(book->getTitle());
             controller->removeBook(bookId);
-            model->refresh();
             updateBookCount();
             QMessageBox::information(this, "删除成功", QString("图书《%1》已成功删除！").arg(title));
         }
@@ -830,15 +892,18 @@ void MainWindow::setupUi() {
             }
             
             // Create borrower
-            Borrower* borrower = nullptr;
+            std::unique_ptr<Borrower> borrower;
             if (type == "student") {
-                borrower = new Student(id.toStdString(), name.toStdString(), 
+                borrower = std::make_unique<Student>(id.toStdString(), name.toStdString(), 
                     dept.toStdString(), extra.toStdString(), limit);
             } else {
-                borrower = new Teacher(id.toStdString(), name.toStdString(), 
+                borrower = std::make_unique<Teacher>(id.toStdString(), name.toStdString(), 
                     dept.toStdString(), extra.toStdString(), limit);
             }
-            controller->addBorrower(borrower);
+            if (!controller->addBorrower(std::move(borrower))) {
+                QMessageBox::warning(this, "添加失败", QString("借阅人ID「%1」已存在！").arg(id));
+                return;
+            }
             
             // Create login user account
             if (dbManager && dbManager->isConnected()) {
@@ -1247,14 +1312,20 @@ void MainWindow::filterBooks() {
 
     auto allBooks = controller->allBooks();
     std::vector<Book*> filtered;
+    // 分类/作者是驻留字符串，同一取值只需转换、匹配一次
+    std::unordered_map<Symbol, bool, Symbol::Hash> symbolMatches;
+    auto symbolMatch = [&](Symbol symbol) {
+        auto it = symbolMatches.find(symbol);
+        if (it == symbolMatches.end()) {
+            bool hit = QString::fromStdString(symbol.str()).toLower().contains(searchText);
+            it = symbolMatches.emplace(symbol, hit).first;
+        }
+        return it->second;
+    };
     for (auto* book : allBooks) {
-        QString title = QString::fromStdString(book->getTitle()).toLower();
-        QString author = QString::fromStdString(book->getAuthor()).toLower();
-        QString category = QString::fromStdString(book->getCategory()).toLower();
-        QString isbn = QString::fromStdString(book->getIsbn()).toLower();
-        
-        if (title.contains(searchText) || author.contains(searchText) || 
-            category.contains(searchText) || isbn.contains(searchText)) {
+        if (symbolMatch(book->getAuthorSymbol()) || symbolMatch(book->getCategorySymbol()) ||
+            QString::fromStdString(book->getTitle()).toLower().contains(searchText) ||
+            QString::fromStdString(book->getIsbn()).toLower().contains(searchText)) {
             filtered.push_back(book);
         }
     }
@@ -1265,15 +1336,14 @@ void MainWindow::filterBooks() {
 }
 
 void MainWindow::updateBookCount() {
-    auto allBooks = controller->allBooks();
-    int totalCopies = 0, available = 0, borrowed = 0;
-    for (auto* book : allBooks) {
-        totalCopies += book->getTotalCopies();
-        available += book->getAvailableCopies();
-        borrowed += (book->getTotalCopies() - book->getAvailableCopies());
+    int totalTitles = 0, totalCopies = 0, available = 0, borrowed = 0;
+    for (const auto& row : controller->categoryHistogram()) {
+        totalTitles += row.titles;
+        totalCopies += row.totalCopies;
+        available += row.availableCopies;
+        borrowed += row.borrowedCopies;
     }
     
-    int totalTitles = static_cast<int>(allBooks.size());
     if (bookCountLabel) {
         bookCountLabel->setText(
             QString("当前馆藏: %1 种图书，共 %2 册。").arg(totalTitles).arg(totalCopies));
@@ -1437,6 +1507,7 @@ void MainWindow::onLogout() {
             bool isAdmin = (currentUserType == "admin");
             editBookAct->setEnabled(isAdmin);
             addBookAct->setEnabled(isAdmin);
+            importBooksAct->setEnabled(isAdmin);
             removeBookAct->setEnabled(isAdmin);
             addUserAct->setEnabled(isAdmin);
             resetPasswordAct->setEnabled(isAdmin);
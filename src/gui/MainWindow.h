@@ -67,6 +67,7 @@ private:
     //actions
     QAction* editBookAct;
     QAction* addBookAct;
+    QAction* importBooksAct;
     QAction* removeBookAct;
     QAction* addUserAct;
     QAction* resetPasswordAct;
@@ -1,18 +1,32 @@
+#include "BookImporter.h"
 #include "FileManager.h"
 #include "Library.h"
+#include "LibraryJournal.h"
+#include "LibraryLog.h"
+#include "SmallIntSet.h"
 #include "Student.h"
+#include "Teacher.h"
+#include "TitleIndex.h"
+#include "TsvFormat.h"
 
+#include <algorithm>
 #include <cassert>
+#include <chrono>
 #include <filesystem>
+#include <fstream>
 #include <iostream>
+#include <memory>
+#include <sstream>
+#include <thread>
 
 int main() {
     Library library("Test Library", "Unit Test");
     library.addBook(Book(1, "C++ Primer", "Lippman", "ISBN-001", "CS", 3));
     library.addBook(Book(2, "Design Patterns", "GoF", "ISBN-002", "CS", 2));
 
-    auto* user = new Student("2023001", "测试用户", "计算机学院", "软件工程", 3);
-    library.addBorrower(user);
+    assert(library.addBorrower(std::make_unique<Student>("2023001", "测试用户", "计算机学院", "软件工程", 3)));
+    Borrower* user = library.findBorrowerById("2023001");
+    assert(user != nullptr);
     assert(library.findBookById(1) != nullptr);
 
     bool borrowOk = user->borrowBookFromLibrary(library, 1);
@@ -22,6 +36,165 @@ int main() {
     assert(tracked->getAvailableCopies() == tracked->getTotalCopies() - 1);
     user->returnBookToLibrary(library, 1);
     assert(tracked->getAvailableCopies() == tracked->getTotalCopies());
+    assert(user->getBorrowHistory().size() == 2);
+    assert(user->getBorrowHistory().recent(0).action == BorrowAction::Return);
+    assert(user->getBorrowHistory().recent(1).bookId == 1);
+    {
+        // checkout/checkin：校验失败时不修改任何状态
+        assert(library.addBorrower(std::make_unique<Student>("2023009", "限额用户", "计算机学院", "软件工程", 1)));
+        assert(library.checkout("nobody", 1) == LoanResult::BorrowerNotFound);
+        assert(library.checkout("2023009", 999) == LoanResult::BookNotFound);
+        assert(library.checkout("2023009", 1, 0) == LoanResult::InvalidDays);
+        assert(library.checkin("2023009", 1) == LoanResult::NotBorrowed);
+        assert(library.checkout("2023009", 1) == LoanResult::Ok);
+        assert(library.checkout("2023009", 2) == LoanResult::LimitReached);
+        assert(library.getAvailableCopies() == 4 && library.verifyStatistics());
+        assert(library.checkin("2023009", 1) == LoanResult::Ok);
+        assert(library.findBorrowerById("2023009")->getCurrentBorrowCount() == 0);
+
+        // 从数据库恢复：载入时已借出、未归属借阅人的副本归属给借阅人，副本数不变
+        assert(library.addBook(*Book::withCounts(50, "Loaned", "Author", "ISBN", "CS", 1, 0)));
+        assert(library.assignOutstandingLoan("2023009", 50) == LoanResult::Ok);
+        assert(library.findBorrowerById("2023009")->hasBorrowedBook(50));
+        assert(library.getAvailableCopies() == 5);
+        assert(library.assignOutstandingLoan("2023009", 1) == LoanResult::NotBorrowed);
+        assert(library.checkin("2023009", 50) == LoanResult::Ok);
+        assert(library.removeBorrower("2023009") && library.removeBook(50));
+    }
+    {
+        // 借还历史：写满后覆盖最旧的记录
+        BorrowHistory history;
+        for (int id = 0; id < 25; ++id) history.record(id, BorrowAction::Borrow, id);
+        assert(history.size() == BorrowHistory::kCapacity);
+        assert(history.recent(0).bookId == 24);
+        assert(history.recent(BorrowHistory::kCapacity - 1).bookId == 5);
+    }
+
+    {
+        // 事件消息：默认静默，安装 sink 后按级别过滤
+        std::vector<std::string> warnings;
+        LibraryLog::setSink([&warnings](LogLevel, const std::string& message) { warnings.push_back(message); },
+                            LogLevel::Warning);
+        assert(!library.addBook(Book(1, "Duplicate", "Nobody", "ISBN-DUP", "CS", 1)));
+        assert(!library.removeBook(424242));
+        LibraryLog::reset();
+        assert(!library.removeBook(424242));
+        assert(warnings.size() == 2 && warnings[0] == "添加失败：ID为 1 的图书已存在");
+    }
+
+    // ID 索引：重复ID被拒绝，插入大量图书后已有指针仍然有效
+    assert(!library.addBook(Book(1, "Duplicate", "Nobody", "ISBN-DUP", "CS", 1)));
+    Book* stable = library.findBookById(2);
+    for (int id = 100; id < 3000; ++id) {
+        library.addBook(Book(id, "Bulk", "Author", "ISBN", "Bulk", 1));
+    }
+    assert(library.findBookById(2) == stable);
+    assert(stable->getTitle() == "Design Patterns");
+    BookHandle staleHandle = library.handleOf(100);
+    assert(library.resolve(staleHandle) == library.findBookById(100));
+    assert(library.removeBook(100));
+    assert(library.findBookById(100) == nullptr);
+    assert(library.resolve(staleHandle) == nullptr);
+    library.addBook(Book(100, "Reused Slot", "Author", "ISBN", "Bulk", 1));
+    assert(library.resolve(staleHandle) == nullptr);
+    assert(library.resolve(library.handleOf(100))->getTitle() == "Reused Slot");
+    assert(library.removeBook(100));
+    assert(library.findBookById(2999) != nullptr);
+    // 从桶中间删除：桶尾移入空位，其余图书仍可按分类查到
+    assert(library.removeBook(1500));
+    auto bulk = library.findBooksByCategory("Bulk");
+    assert(bulk.size() == 2898);
+    assert(std::none_of(bulk.begin(), bulk.end(), [](Book* book) { return book->getBookId() == 1500; }));
+    assert(library.removeBook(2999) && library.findBooksByAuthor("Author").size() == 2897);
+    for (int id = 101; id < 2999; ++id) {
+        if (id != 1500) library.removeBook(id);
+    }
+    assert(library.getBooks().size() == 2);
+
+    // 二级索引：分类/作者/书名查询与增删保持同步
+    assert(library.findBooksByCategory("CS").size() == 2);
+    assert(library.findBooksByCategory("Bulk").empty());
+    assert(library.findBooksByAuthor("GoF").size() == 1);
+    assert(library.findBookByTitle("C++ Primer") == library.findBookById(1));
+    assert(library.findBookByTitle("Missing") == nullptr);
+    // 分类/作者驻留：相同取值共享同一份字符串
+    assert(library.findBookById(1)->getCategorySymbol() == library.findBookById(2)->getCategorySymbol());
+    assert(&library.findBookById(1)->getCategory() == &library.findBookById(2)->getCategory());
+
+    // 在借表：同一本书可同时借出多个副本
+    assert(library.addBorrower(std::make_unique<Student>("2023010", "第二用户", "计算机学院", "软件工程", 3)));
+    assert(library.checkout("2023001", 1) == LoanResult::Ok);
+    assert(library.checkout("2023010", 1) == LoanResult::Ok);
+    assert(library.getBorrowedCopies() == 2);
+    assert(library.loanSnapshot().size() == 1 && library.loanSnapshot()[0].loans == 2);
+    assert(library.checkin("2023001", 1) == LoanResult::Ok);
+    assert(library.checkin("2023010", 1) == LoanResult::Ok);
+    assert(library.checkin("2023010", 1) == LoanResult::NotBorrowed);
+    assert(library.loanSnapshot().empty());
+
+    // 增量统计与全量重算一致
+    assert(library.getTotalBooks() == 2);
+    assert(library.getTotalCopies() == 5);
+    assert(library.checkout("2023001", 2) == LoanResult::Ok && library.checkout("2023010", 2) == LoanResult::Ok);
+    assert(library.getAvailableBooks() == 1);
+    assert(library.getAvailableCopies() == 3);
+    assert(library.verifyStatistics());
+    {
+        // 数值列镜像与 Book 保持一致
+        const BookStore& store = library.getBooks();
+        int columnAvailable = 0;
+        for (std::size_t chunk = 0; chunk < store.chunkCount(); ++chunk) {
+            const BookStore::CountColumns columns = store.columns(chunk);
+            for (std::size_t i = 0; i < columns.size; ++i) columnAvailable += columns.available(i);
+        }
+        assert(columnAvailable == library.getAvailableCopies());
+    }
+    auto histogram = library.categoryHistogram();
+    assert(histogram.size() == 1);
+    assert(histogram[0].category == "CS" && histogram[0].titles == 2);
+    assert(histogram[0].borrowedCopies == 2 && histogram[0].availableCopies == 3);
+    assert(library.checkin("2023001", 2) == LoanResult::Ok && library.checkin("2023010", 2) == LoanResult::Ok);
+    assert(library.removeBorrower("2023010"));
+
+    // 借阅人目录：按ID去重，删除后与末尾交换仍能正确查找
+    assert(!library.addBorrower(std::make_unique<Student>("2023001", "重复", "计算机学院", "软件工程", 3)));
+    for (int i = 0; i < 100; ++i) {
+        assert(library.addBorrower(std::make_unique<Teacher>("T" + std::to_string(i), "教师", "学院", "讲师", 10)));
+    }
+    Borrower* lastTeacher = library.findBorrowerById("T99");
+    assert(library.removeBorrower("T0"));
+    assert(!library.removeBorrower("T0"));
+    assert(library.findBorrowerById("T0") == nullptr);
+    assert(library.findBorrowerById("T99") == lastTeacher);
+    assert(library.findBorrowerById("2023001") == user);
+    assert(library.getBorrowers().size() == 100);
+
+    {
+        // 书名索引：同一哈希的多项按插入顺序查找，删除后其后的项仍可找到，扩容后保持不变
+        TitleIndex index;
+        index.insert(42, 1);
+        index.insert(42, 2);
+        index.insert(42 + 16, 3);
+        assert(index.find(42, [](std::size_t) { return true; }) == 1);
+        assert(index.erase(42, 1) && !index.erase(42, 1));
+        assert(index.find(42, [](std::size_t) { return true; }) == 2);
+        assert(index.find(42 + 16, [](std::size_t slot) { return slot == 3; }) == 3);
+        for (std::size_t i = 0; i < 1000; ++i) index.insert(1000 + i, i);
+        assert(index.size() == 1002 && index.find(1500, [](std::size_t) { return true; }) == 500);
+        assert(index.find(7, [](std::size_t) { return true; }) == TitleIndex::npos);
+    }
+
+    {
+        // 已借图书集合：超过内联容量后转为哈希，计数由集合大小得出
+        SmallIntSet ids;
+        for (int id = 0; id < 20; ++id) assert(ids.insert(id));
+        assert(!ids.insert(5));
+        assert(ids.erase(0) && !ids.erase(0));
+        assert(ids.size() == 19 && ids.contains(19) && !ids.contains(0));
+        int sum = 0;
+        for (int id : ids) sum += id;
+        assert(sum == 190);
+    }
 
     std::filesystem::path tempDir = std::filesystem::temp_directory_path();
     auto booksFile = tempDir / "library_books_test.tsv";
@@ -31,16 +204,426 @@ int main() {
     assert(FileManager::saveBorrowersToFile(library.getBorrowers(), usersFile.string()));
 
     std::vector<Book> loadedBooks;
-    std::vector<Borrower*> loadedUsers;
+    std::vector<std::unique_ptr<Borrower>> loadedUsers;
     assert(FileManager::loadBooksFromFile(loadedBooks, booksFile.string()));
     assert(FileManager::loadBorrowersFromFile(loadedUsers, usersFile.string()));
     assert(!loadedBooks.empty());
     assert(!loadedUsers.empty());
 
-    for (auto borrower : loadedUsers) delete borrower;
     std::filesystem::remove(booksFile);
     std::filesystem::remove(usersFile);
 
+    {
+        // 按总数与可借数直接构造，数量不合法时拒绝
+        auto loaded = Book::withCounts(5, "Loaded", "A", "ISBN", "CS", 100, 0);
+        assert(loaded && loaded->getAvailableCopies() == 0 && !loaded->getIsAvailable());
+        assert(loaded->returnBook() && loaded->getIsAvailable());
+        assert(!Book::withCounts(5, "Bad", "A", "ISBN", "CS", 2, 3));
+        assert(!Book::withCounts(5, "Bad", "A", "ISBN", "CS", -1, 0));
+    }
+    {
+        // 缓冲写出：各种长度与位置的制表符/换行都被转义，小缓冲区多次写出后内容不变
+        std::ostringstream written;
+        std::string expected;
+        {
+            tsv::BufferedWriter writer(written, 64);
+            for (std::size_t length = 0; length <= 20; ++length) {
+                for (std::size_t pos = 0; pos <= length; ++pos) {
+                    std::string title(length, 'x');
+                    if (pos < length) title[pos] = pos % 2 ? '\t' : '\n';
+                    Book book(static_cast<int>(length * 100 + pos), title, "A", "I", "C", 12);
+                    writer.writeBook(book);
+                    std::string escaped;
+                    for (char c : title) escaped += c == '\t' ? "\\t" : c == '\n' ? "\\n" : std::string(1, c);
+                    expected += std::to_string(book.getBookId()) + "\t" + escaped + "\tA\tI\tC\t12\t12\n";
+                }
+            }
+            writer.writeBorrower(Teacher("T\t1", "教师", "学院", "讲师", 10));
+            expected += "教师\tT\\t1\t教师\t学院\t10\t讲师\n";
+        }
+        assert(written.str() == expected);
+    }
+    {
+        // 映射文件解析：转义字段、CRLF 行尾与非法记录
+        std::ofstream raw(booksFile, std::ios::binary);
+        raw << "7\tTab\\there\tA\tISBN\tCS\t3\t1\r\n"
+            << "bad row\n"
+            << "8\tT\tA\tISBN\tCS\tx\t1\n"
+            << "\n"
+            << "10\tOverdrawn\tA\tISBN\tCS\t2\t3\n"
+            << "9\tPlain\tA\tISBN\tCS\t2\t2";
+        raw.close();
+        std::vector<Book> parsed;
+        assert(FileManager::loadBooksFromFile(parsed, booksFile.string()));
+        assert(parsed.size() == 2);
+        assert(parsed[0].getTitle() == "Tab\there" && parsed[0].getAvailableCopies() == 1);
+        assert(parsed[1].getBookId() == 9 && parsed[1].getTotalCopies() == 2);
+        std::filesystem::remove(booksFile);
+        assert(!FileManager::loadBooksFromFile(parsed, booksFile.string()));
+    }
+    {
+        // 分块并行解析：记录顺序与非法行报告和单线程一致
+        std::ofstream raw(booksFile);
+        for (int i = 0; i < 40000; ++i) {
+            if (i % 9973 == 0) raw << "broken line " << i << '\n';
+            raw << i << "\tTitle " << i << "\tA\tISBN\tCS\t2\t1\n";
+        }
+        raw.close();
+        auto loadWith = [&](unsigned threads, std::vector<Book>& out) {
+            std::ostringstream errors;
+            std::streambuf* previous = std::cerr.rdbuf(errors.rdbuf());
+            FileManager::setLoaderThreads(threads);
+            assert(FileManager::loadBooksFromFile(out, booksFile.string()));
+            std::cerr.rdbuf(previous);
+            return errors.str();
+        };
+        std::vector<Book> serial, parallel;
+        std::string serialErrors = loadWith(1, serial);
+        std::string parallelErrors = loadWith(8, parallel);
+        FileManager::setLoaderThreads(0);
+        assert(serial.size() == 40000 && parallel.size() == serial.size());
+        for (std::size_t i = 0; i < serial.size(); ++i) assert(parallel[i].getBookId() == static_cast<int>(i));
+        assert(parallelErrors == serialErrors);
+        assert(parallelErrors.find(booksFile.string() + ":9975: ") != std::string::npos);
+        std::filesystem::remove(booksFile);
+    }
+
+    {
+        // 二进制快照：图书、借阅人与在借归属往返一致，内容损坏时拒绝载入
+        assert(library.checkout("2023001", 2) == LoanResult::Ok);
+        auto snapshotFile = tempDir / "library_snapshot_test.bin";
+        assert(FileManager::saveBinarySnapshot(library, snapshotFile.string()));
+        Library restored;
+        assert(FileManager::loadBinarySnapshot(restored, snapshotFile.string()));
+        assert(restored.getBooks().size() == library.getBooks().size());
+        assert(restored.getBorrowers().size() == library.getBorrowers().size());
+        assert(restored.findBookById(2)->getAvailableCopies() == library.findBookById(2)->getAvailableCopies());
+        assert(&restored.findBookById(1)->getCategory() == &library.findBookById(1)->getCategory());
+        assert(dynamic_cast<Student*>(restored.findBorrowerById("2023001"))->getMajor() == "软件工程");
+        assert(restored.findBorrowerById("2023001")->hasBorrowedBook(2));
+        assert(restored.checkin("2023001", 2) == LoanResult::Ok && restored.verifyStatistics());
+        assert(library.checkin("2023001", 2) == LoanResult::Ok);
+
+        std::fstream corrupt(snapshotFile, std::ios::in | std::ios::out | std::ios::binary);
+        corrupt.seekp(-3, std::ios::end);
+        corrupt.put('\x7f');
+        corrupt.close();
+        Library rejected;
+        assert(!FileManager::loadBinarySnapshot(rejected, snapshotFile.string()));
+        assert(rejected.getBooks().empty());
+        std::filesystem::remove(snapshotFile);
+    }
+
+    {
+        // 追加日志：借还与增删写入日志，载入快照时重放；快照被重写后旧日志不再生效
+        auto journalBooks = tempDir / "library_journal_books.tsv";
+        auto journalUsers = tempDir / "library_journal_users.tsv";
+        auto journalFile = tempDir / "library_journal_test.log";
+        std::filesystem::remove(journalFile);
+        Library live;
+        live.addBook(Book(1, "Journal", "Author", "ISBN", "CS", 2));
+        live.addBorrower(std::make_unique<Student>("S1", "学生", "学院", "软件工程", 3));
+        LibraryJournal::Options options;
+        options.syncInterval = std::chrono::milliseconds(1);
+        {
+            LibraryJournal journal(live, journalFile.string(), journalBooks.string(), journalUsers.string(), options);
+            assert(journal.start()); // 没有日志时先写出快照
+            assert(std::filesystem::exists(journalBooks) && journal.compactionCount() == 1);
+            assert(live.checkout("S1", 1) == LoanResult::Ok);
+            assert(live.addBook(Book(2, "Tab\tTitle", "Author", "ISBN", "文学", 1)));
+            assert(live.addBorrower(std::make_unique<Teacher>("T1", "教师", "学院", "讲师", 5)));
+            assert(live.checkout("T1", 2) == LoanResult::Ok);
+            assert(live.updateBook(2, Book(2, "Tab\tTitle", "Editor", "ISBN", "历史", 1))); // 在借时修改
+            assert(live.checkout("T1", 1) == LoanResult::Ok);
+            assert(live.removeBorrower("S1"));
+        }
+        std::ofstream(journalFile, std::ios::app) << "C\tT1"; // 写了一半的记录
+        Library replayed;
+        assert(FileManager::loadLibrarySnapshot(replayed, journalBooks.string(), journalUsers.string(),
+                                                journalFile.string()));
+        assert(replayed.findBookById(1)->getAvailableCopies() == 0);
+        assert(replayed.findBookById(2)->getTitle() == "Tab\tTitle");
+        assert(replayed.findBorrowerById("S1") == nullptr);
+        assert(replayed.findBorrowerById("T1")->hasBorrowedBook(2));
+        assert(replayed.findBookById(2)->getAvailableCopies() == 0 && replayed.findBooksByCategory("历史").size() == 1);
+        assert(replayed.verifyStatistics());
+
+        // 日志不断增长时由后台线程压缩为新快照
+        options.compactBytes = 512;
+        {
+            LibraryJournal journal(replayed, journalFile.string(), journalBooks.string(), journalUsers.string(), options);
+            assert(journal.start() && journal.compactionCount() == 1); // 末尾不完整，不能继续追加
+            for (int i = 0; i < 200; ++i) {
+                assert(replayed.checkin("T1", 2) == LoanResult::Ok);
+                assert(replayed.checkout("T1", 2) == LoanResult::Ok);
+            }
+            assert(replayed.checkin("T1", 1) == LoanResult::Ok);
+            for (int wait = 0; wait < 2000 && journal.compactionCount() < 2; ++wait) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            assert(journal.compactionCount() >= 2);
+            assert(journal.sync());
+        }
+        Library compacted;
+        assert(FileManager::loadLibrarySnapshot(compacted, journalBooks.string(), journalUsers.string(),
+                                                journalFile.string()));
+        assert(compacted.findBookById(1)->getAvailableCopies() == 1);
+        assert(compacted.findBookById(2)->getAvailableCopies() == 0);
+
+        // 绕过日志重写快照后，日志中的记录已包含在快照里，不再重放
+        // 快照不含借阅人名下的借阅，先把借出的副本归属给 T1 再归还
+        assert(compacted.assignOutstandingLoan("T1", 2) == LoanResult::Ok);
+        assert(compacted.checkin("T1", 2) == LoanResult::Ok);
+        assert(FileManager::saveLibrarySnapshot(compacted, journalBooks.string(), journalUsers.string()));
+        assert(LibraryJournal::replay(compacted, journalFile.string(), journalBooks.string(), journalUsers.string()) == 0);
+        std::filesystem::remove(journalFile);
+        std::filesystem::remove(journalBooks);
+        std::filesystem::remove(journalUsers);
+    }
+
+    {
+        // 修改记录：载入的内容是基线；只记下有修改的图书与借阅人，增量保存跳过未修改的文件
+        auto changeBooks = tempDir / "library_changes_books.tsv";
+        auto changeUsers = tempDir / "library_changes_users.tsv";
+        std::filesystem::remove(changeBooks);
+        std::filesystem::remove(changeUsers);
+        Library changed;
+        changed.setBooks({Book(1, "One", "Author", "ISBN", "CS", 2), Book(2, "Two", "Author", "ISBN", "CS", 1)});
+        std::vector<std::unique_ptr<Borrower>> loaded;
+        loaded.push_back(std::make_unique<Student>("S1", "学生", "学院", "软件工程", 3));
+        changed.setBorrowers(std::move(loaded));
+        assert(changed.takeChanges().empty());
+        assert(FileManager::saveLibraryChanges(changed, changeBooks.string(), changeUsers.string())); // 文件不存在时照常写出
+
+        assert(changed.checkout("S1", 1) == LoanResult::Ok);
+        assert(changed.addBook(Book(3, "Three", "Author", "ISBN", "CS", 1)));
+        assert(changed.removeBook(2));
+        LibraryChangeSet changes = changed.takeChanges();
+        std::sort(changes.books.begin(), changes.books.end());
+        assert((changes.books == std::vector<int>{1, 3}) && (changes.removedBooks == std::vector<int>{2}));
+        assert(!changes.borrowersChanged() && changed.takeChanges().empty());
+        changed.restoreChanges(changes);
+        assert(changed.removeBook(3)); // 放回后又被删除的以当前状态为准
+        changes = changed.takeChanges();
+        std::sort(changes.removedBooks.begin(), changes.removedBooks.end());
+        assert((changes.books == std::vector<int>{1}) && (changes.removedBooks == std::vector<int>{2, 3}));
+        changed.restoreChanges(changes);
+
+        std::ofstream(changeUsers, std::ios::trunc) << "untouched\n";
+        assert(FileManager::saveLibraryChanges(changed, changeBooks.string(), changeUsers.string()));
+        std::ifstream usersIn(changeUsers);
+        std::string usersLine;
+        assert(std::getline(usersIn, usersLine) && usersLine == "untouched"); // 借阅人未修改，文件未重写
+        std::vector<Book> savedBooks;
+        assert(FileManager::loadBooksFromFile(savedBooks, changeBooks.string()) && savedBooks.size() == 1);
+        assert(savedBooks[0].getAvailableCopies() == 1);
+        assert(changed.takeChanges().empty());
+
+        // 日志压缩同样只重写有修改的快照文件
+        auto changeJournal = tempDir / "library_changes.journal";
+        std::filesystem::remove(changeJournal);
+        {
+            LibraryJournal journal(changed, changeJournal.string(), changeBooks.string(), changeUsers.string());
+            assert(journal.start());
+            std::ofstream(changeUsers, std::ios::trunc) << "untouched again\n";
+            assert(changed.checkin("S1", 1) == LoanResult::Ok);
+            assert(journal.checkpoint());
+        }
+        std::ifstream usersAgain(changeUsers);
+        assert(std::getline(usersAgain, usersLine) && usersLine == "untouched again");
+        assert(FileManager::loadBooksFromFile(savedBooks, changeBooks.string()) && savedBooks[0].getAvailableCopies() == 2);
+        std::filesystem::remove(changeJournal);
+        std::filesystem::remove(changeBooks);
+        std::filesystem::remove(changeUsers);
+    }
+
+    {
+        // 原地修改图书：在借记录、句柄保留；ID 冲突或总数过少时拒绝且原书不变
+        Library edited("Edit Library", "Unit Test");
+        assert(edited.addBook(Book(1, "旧书名", "作者甲", "ISBN-1", "CS", 3)));
+        assert(edited.addBook(Book(2, "另一本", "作者乙", "ISBN-2", "CS", 1)));
+        assert(edited.addBorrower(std::make_unique<Student>("S1", "学生", "学院", "软件工程", 3)));
+        assert(edited.checkout("S1", 1) == LoanResult::Ok);
+        const BookHandle handle = edited.handleOf(1);
+        edited.takeChanges();
+
+        assert(!edited.updateBook(1, Book(2, "冲突", "作者", "ISBN", "CS", 3)));
+        assert(!edited.updateBook(1, Book(7, "有借出", "作者", "ISBN", "CS", 3)));
+        assert(!edited.updateBook(1, Book(1, "太少", "作者", "ISBN", "CS", 0)));
+        assert(!edited.updateBook(9, Book(9, "不存在", "作者", "ISBN", "CS", 1)));
+        assert(edited.findBookById(1)->getTitle() == "旧书名" && edited.findBookById(2)->getTitle() == "另一本");
+        assert(edited.takeChanges().empty());
+
+        assert(edited.updateBook(1, Book(1, "新书名", "作者丙", "ISBN-1", "文学", 5)));
+        const Book* updated = edited.resolve(handle);
+        assert(updated && updated->getTitle() == "新书名" && updated->getAvailableCopies() == 4);
+        assert(edited.findBooksByCategory("CS").size() == 1 && edited.findBooksByCategory("文学").size() == 1);
+        assert(edited.findBooksByAuthor("作者甲").empty() && edited.findBookByTitle("新书名") == updated);
+        assert(edited.getBorrowedCopies() == 1 && edited.verifyStatistics());
+        assert(edited.checkin("S1", 1) == LoanResult::Ok);
+        assert(updated->getAvailableCopies() == 5);
+
+        // 无在借副本时可以修改 ID，旧 ID 记为删除
+        assert(edited.updateBook(1, Book(3, "新书名", "作者丙", "ISBN-1", "文学", 5)));
+        assert(!edited.findBookById(1) && edited.findBookById(3) == edited.resolve(handle));
+        LibraryChangeSet editChanges = edited.takeChanges();
+        assert((editChanges.books == std::vector<int>{3}));
+        assert((editChanges.removedBooks == std::vector<int>{1}));
+        assert(edited.verifyStatistics());
+    }
+
+    {
+        // 写出修改前复制行：副本与目录脱钩，复制后删除原对象不影响写出
+        Library copied("Copy Library", "Unit Test");
+        assert(copied.addBook(Book(1, "书一", "作者", "ISBN-1", "CS", 2)));
+        assert(copied.addBook(Book(2, "书二", "作者", "ISBN-2", "CS", 1)));
+        assert(copied.addBorrower(std::make_unique<Student>("S1", "学生", "学院", "软件工程", 3)));
+        assert(copied.addBorrower(std::make_unique<Teacher>("T1", "教师", "学院", "讲师", 8)));
+        assert(copied.checkout("S1", 1) == LoanResult::Ok);
+        LibraryChangeSet rows = copied.takeChanges();
+        assert(copied.removeBook(2));
+        std::vector<Book> bookRows;
+        std::vector<std::unique_ptr<Borrower>> borrowerRows;
+        copied.copyChangedRows(rows, bookRows, borrowerRows);
+        assert(bookRows.size() == 1 && bookRows[0].getBookId() == 1 && bookRows[0].getAvailableCopies() == 1);
+        assert(borrowerRows.size() == 2);
+        assert(copied.removeBorrower("T1") && copied.removeBook(1));
+        std::sort(borrowerRows.begin(), borrowerRows.end(),
+                  [](const auto& a, const auto& b) { return a->getId() < b->getId(); });
+        assert(borrowerRows[0]->getKind() == BorrowerKind::Student && borrowerRows[0]->getMaxBorrowLimit() == 3);
+        assert(static_cast<const Student&>(*borrowerRows[0]).getMajor() == "软件工程");
+        assert(borrowerRows[1]->getKind() == BorrowerKind::Teacher && borrowerRows[1]->getName() == "教师");
+        assert(static_cast<const Teacher&>(*borrowerRows[1]).getTitle() == "讲师");
+        assert(bookRows[0].getTitle() == "书一");
+    }
+
+    {
+        // 登录：按 ID 查找缓存的索引，文件被重写后重新载入
+        auto loginUsers = tempDir / "library_login_users.tsv";
+        std::vector<std::unique_ptr<Borrower>> accounts;
+        accounts.push_back(std::make_unique<Student>("2023000001", "学生", "学院", "软件工程", 3));
+        assert(FileManager::saveBorrowersToFile(accounts, loginUsers.string()));
+        std::unique_ptr<Borrower> login(FileManager::loginUser(loginUsers.string(), "2023000001", "000001"));
+        assert(login && login->getName() == "学生" && login->getKind() == BorrowerKind::Student);
+        assert(!FileManager::loginUser(loginUsers.string(), "2023000001", "000002"));
+        assert(!FileManager::loginUser(loginUsers.string(), "T2023001", "023001"));
+
+        accounts.push_back(std::make_unique<Teacher>("T2023001", "教师", "学院", "讲师", 10));
+        assert(FileManager::saveBorrowersToFile(accounts, loginUsers.string()));
+        login.reset(FileManager::loginUser(loginUsers.string(), "T2023001", "023001"));
+        assert(login && login->getKind() == BorrowerKind::Teacher);
+        std::ofstream(loginUsers, std::ios::trunc) << "学生\tS9\t外部\t学院\t3\t专业\nbroken\tT2023001\n";
+        login.reset(FileManager::loginUser(loginUsers.string(), "S9", "S9"));
+        assert(login && login->getName() == "外部");
+        assert(!FileManager::loginUser(loginUsers.string(), "T2023001", "023001"));
+        std::filesystem::remove(loginUsers);
+        assert(!FileManager::loginUser(loginUsers.string(), "S9", "S9"));
+    }
+
+    {
+        // 批量导入：CSV 引号字段、表头、非法记录与重复 ID；小批次与小队列下流水线仍完整
+        auto importCsv = tempDir / "library_import.csv";
+        std::ofstream(importCsv, std::ios::binary | std::ios::trunc)
+            << "ID,书名,作者,ISBN,分类,总数,可借数\r\n"
+            << "101,\"Hello, World\",作者甲,ISBN-101,CS,3,2\r\n"
+            << "102,\"多行\n书名 \"\"引号\"\"\",作者乙,ISBN-102,文学,1\n"
+            << "abc,坏记录,作者,ISBN,CS,1\n"
+            << "\n"
+            << "1,已存在,作者,ISBN,CS,1\n"
+            << "103,,作者,ISBN,CS,1\n"
+            << "104,可借数过多,作者,ISBN,CS,1,5\n"
+            << "105,末行无换行,作者丙,ISBN-105,历史,2";
+        Library imported("Import Library", "Unit Test");
+        imported.addBook(Book(1, "旧书", "作者", "ISBN-1", "CS", 1));
+        std::size_t batches = 0;
+        BookImporter::Options options;
+        options.batchSize = 2;
+        options.queueBatches = 1;
+        BookImporter::Result result = BookImporter(options).run(importCsv.string(),
+            [&](const std::vector<Book>& batch) {
+                assert(batch.size() <= 2);
+                return imported.addBooks(batch);
+            },
+            [&](const BookImporter::Progress& progress) {
+                assert(progress.bytesRead <= progress.totalBytes);
+                ++batches;
+                return true;
+            });
+        assert(result.ok && !result.cancelled && batches >= 3);
+        assert(result.progress.bytesRead == result.progress.totalBytes);
+        assert(result.progress.records == 7 && result.progress.imported == 3);
+        assert(result.progress.skipped == 1 && result.progress.rejected == 3);
+        assert(result.errors.size() == 3 && result.errors[0] == "第 5 行: ID 不是正整数");
+        assert(result.errors[1] == "第 8 行: 书名为空" && result.errors[2] == "第 9 行: 副本数不合法");
+        Book* quoted = imported.findBookById(101);
+        assert(quoted && quoted->getTitle() == "Hello, World" && quoted->getAvailableCopies() == 2);
+        Book* multiline = imported.findBookById(102);
+        assert(multiline && multiline->getTitle() == "多行\n书名 \"引号\"" && multiline->getAvailableCopies() == 1);
+        assert(imported.findBookById(105) && imported.findBookById(1)->getTitle() == "旧书");
+        assert(imported.verifyStatistics());
+        LibraryChangeSet importChanges = imported.takeChanges();
+        std::sort(importChanges.books.begin(), importChanges.books.end());
+        assert((importChanges.books == std::vector<int>{1, 101, 102, 105}));
+
+        // TSV 与 books.tsv 同格式；进度回调返回 false 时取消，已写入的批次保留
+        auto importTsv = tempDir / "library_import.tsv";
+        {
+            std::ofstream tsvOut(importTsv, std::ios::trunc);
+            tsvOut << "201\t制表\\t书名\t作者\tISBN\tCS\t2\t2\n";
+            for (int id = 202; id < 230; ++id) tsvOut << id << "\t书" << id << "\t作者\tISBN\tCS\t1\t1\n";
+        }
+        std::size_t calls = 0;
+        result = BookImporter(options).run(importTsv.string(), [&](const std::vector<Book>& batch) {
+            return imported.addBooks(batch);
+        }, [&](const BookImporter::Progress&) { return ++calls < 2; });
+        assert(!result.ok && result.cancelled && result.progress.imported == 4);
+        assert(imported.findBookById(201) && imported.findBookById(201)->getTitle() == "制表\t书名");
+        assert(!imported.findBookById(205));
+
+        // sink 报告失败时中止；文件不存在时直接失败
+        result = BookImporter(options).run(importTsv.string(), [](const std::vector<Book>&) {
+            return BookImporter::kSinkFailed;
+        });
+        assert(!result.ok && !result.cancelled && result.progress.imported == 0);
+        result = BookImporter().run((tempDir / "library_import_missing.csv").string(),
+                                    [](const std::vector<Book>& batch) { return batch.size(); });
+        assert(!result.ok && !result.errors.empty());
+        assert(imported.verifyStatistics());
+
+        // 未闭合的引号：记录超过上限后只丢弃它的首行，其后各行重新切分，不会把余下文件读成一条记录
+        {
+            std::ofstream out(importCsv, std::ios::binary | std::ios::trunc);
+            out << "301,正常,作者,ISBN,CS,1\n"
+                << "302,\"未闭合,作者,ISBN,CS,1\n";
+            for (int id = 303; id < 320; ++id) out << id << ",书" << id << ",作者,ISBN,CS,1\n";
+        }
+        options.maxRecordBytes = 64;
+        options.batchSize = 4;
+        result = BookImporter(options).run(importCsv.string(), [&](const std::vector<Book>& batch) {
+            return imported.addBooks(batch);
+        });
+        assert(result.ok && result.progress.rejected == 1 && result.errors.size() == 1);
+        assert(result.errors[0].rfind("第 2 行: 记录超过 64 字节", 0) == 0);
+        assert(imported.findBookById(301) && !imported.findBookById(302) && imported.findBookById(319));
+        assert(result.progress.imported == 18 && result.progress.records == 19);
+        for (int id = 303; id < 320; ++id) assert(imported.findBookById(id));
+
+        // 单行超长：跳到下一个换行；之后的引号字段不受影响
+        {
+            std::ofstream out(importCsv, std::ios::binary | std::ios::trunc);
+            out << "401," << std::string(100, 'x') << ",作者,ISBN,CS,1\n"
+                << "402,\"引号, 书名\",作者,ISBN,CS,1\n";
+        }
+        result = BookImporter(options).run(importCsv.string(), [&](const std::vector<Book>& batch) {
+            return imported.addBooks(batch);
+        });
+        assert(result.ok && result.progress.rejected == 1 && result.progress.imported == 1);
+        assert(result.errors.size() == 1 && result.errors[0].rfind("第 1 行: ", 0) == 0);
+        assert(!imported.findBookById(401) && imported.findBookById(402)->getTitle() == "引号, 书名");
+        std::filesystem::remove(importCsv);
+        std::filesystem::remove(importTsv);
+    }
+
     std::cout << "Library core tests passed." << std::endl;
     return 0;
 }
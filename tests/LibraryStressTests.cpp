@@ -0,0 +1,189 @@
+#include "FileManager.h"
+#include "Library.h"
+#include "Borrower.h"
+#include "Teacher.h"
+
+#include <atomic>
+#include <cassert>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// 丢弃所有输出且不保存任何状态，多个线程可以同时写入
+class DiscardBuffer : public std::streambuf {
+protected:
+    int overflow(int c) override { return c; }
+    std::streamsize xsputn(const char*, std::streamsize count) override { return count; }
+};
+
+} // namespace
+
+// 多线程压力测试：借还、查询与增删同时进行，结束后统计量必须与全量重算一致
+int main() {
+    constexpr int kBooks = 256;
+    constexpr int kWorkers = 8;
+    constexpr int kRounds = 4000;
+    const char* categories[] = {"CS", "文学", "历史", "科幻"};
+
+    Library library("Stress Library", "Unit Test");
+    for (int id = 1; id <= kBooks; ++id) {
+        library.addBook(Book(id, "Title " + std::to_string(id), "Author " + std::to_string(id % 16),
+                             "ISBN", categories[id % 4], 1 + id % 3));
+    }
+    for (int w = 0; w < kWorkers; ++w) {
+        assert(library.addBorrower(std::make_unique<Teacher>("W" + std::to_string(w), "教师", "学院", "讲师", 10)));
+    }
+    const int totalCopies = library.getTotalCopies();
+
+    std::atomic<bool> stop{false};
+    std::atomic<int> readerErrors{0};
+    // displayAvailableBooks 与快照的输出在并发期间丢弃；线程启动前切换，全部结束后恢复
+    DiscardBuffer discarded;
+    std::streambuf* coutBuffer = std::cout.rdbuf(&discarded);
+
+    // 借还：每个借阅人随机借还共享的图书，副本数不能被超借
+    std::vector<std::thread> workers;
+    for (int w = 0; w < kWorkers; ++w) {
+        workers.emplace_back([&library, w] {
+            const std::string id = "W" + std::to_string(w);
+            std::mt19937 rng(static_cast<unsigned>(w));
+            std::uniform_int_distribution<int> pick(1, kBooks);
+            std::vector<int> held;
+            for (int round = 0; round < kRounds; ++round) {
+                if (!held.empty() && (held.size() >= 10 || rng() % 2 == 0)) {
+                    std::size_t i = rng() % held.size();
+                    assert(library.checkin(id, held[i]) == LoanResult::Ok);
+                    held[i] = held.back();
+                    held.pop_back();
+                } else {
+                    int bookId = pick(rng);
+                    if (library.checkout(id, bookId) == LoanResult::Ok) held.push_back(bookId);
+                }
+            }
+            for (int bookId : held) assert(library.checkin(id, bookId) == LoanResult::Ok);
+        });
+    }
+
+    // 查询：共享锁下的读操作与借还并行
+    std::thread reader([&] {
+        while (!stop.load()) {
+            for (int id = 1; id <= kBooks; id += 7) {
+                if (library.findBookById(id) == nullptr) readerErrors++;
+            }
+            if (library.findBooksByCategory("CS").size() != static_cast<std::size_t>(kBooks / 4)) readerErrors++;
+            int available = library.getAvailableCopies();
+            if (available < 0 || available > library.getTotalCopies()) readerErrors++;
+            for (const auto& row : library.categoryHistogram()) {
+                if (row.borrowedCopies < 0) readerErrors++;
+            }
+            // 数值列扫描：只持有共享锁，借还同时刷新可借数列
+            {
+                auto readLock = library.readLock();
+                const BookStore& books = library.getBooks();
+                for (std::size_t chunk = 0; chunk < books.chunkCount(); ++chunk) {
+                    const BookStore::CountColumns columns = books.columns(chunk);
+                    for (std::size_t i = 0; i < columns.size; ++i) {
+                        const int copies = columns.available(i);
+                        if (copies < 0 || copies > columns.total(i)) readerErrors++;
+                    }
+                }
+            }
+            library.displayAvailableBooks();
+        }
+    });
+
+    // 增删：独占锁下修改目录结构，不影响已有图书的借还
+    std::thread editor([&] {
+        for (int i = 0; i < 500; ++i) {
+            int id = 10000 + i;
+            assert(library.addBook(Book(id, "Temp", "Temp", "ISBN", "Temp", 1)));
+            assert(library.addBorrower(std::make_unique<Teacher>("E" + std::to_string(i), "教师", "学院", "讲师", 1)));
+            assert(library.checkout("E" + std::to_string(i), id) == LoanResult::Ok);
+            assert(library.checkin("E" + std::to_string(i), id) == LoanResult::Ok);
+            assert(library.removeBorrower("E" + std::to_string(i)));
+            assert(library.removeBook(id));
+        }
+    });
+
+    // 二进制快照：借还进行中写出，载入后图书的在借副本数与借阅人的在借记录必须一致
+    const std::string snapshotFile = (std::filesystem::temp_directory_path() / "library_stress_snapshot.bin").string();
+    std::thread snapshotter([&] {
+        for (int i = 0; i < 40; ++i) {
+            if (!FileManager::saveBinarySnapshot(library, snapshotFile)) {
+                readerErrors++;
+                continue;
+            }
+            Library loaded;
+            if (!FileManager::loadBinarySnapshot(loaded, snapshotFile)) {
+                readerErrors++;
+                continue;
+            }
+            int heldCopies = 0;
+            for (const auto& borrower : loaded.getBorrowers()) heldCopies += borrower->getCurrentBorrowCount();
+            if (heldCopies != loaded.getBorrowedCopies() || !loaded.verifyStatistics()) readerErrors++;
+        }
+    });
+
+    for (auto& worker : workers) worker.join();
+    editor.join();
+    snapshotter.join();
+    std::filesystem::remove(snapshotFile);
+    stop.store(true);
+    reader.join();
+    std::cout.rdbuf(coutBuffer);
+
+    assert(readerErrors.load() == 0);
+    assert(library.getTotalBooks() == kBooks);
+    assert(library.getAvailableCopies() == totalCopies);
+    assert(library.getBorrowedCopies() == 0);
+    assert(library.loanSnapshot().empty());
+    assert(library.verifyStatistics());
+    for (int w = 0; w < kWorkers; ++w) {
+        const Borrower* borrower = library.findBorrowerById("W" + std::to_string(w));
+        assert(borrower->getCurrentBorrowCount() == 0);
+        assert(borrower->getBorrowHistory().size() == BorrowHistory::kCapacity);
+    }
+
+    // 抢借最后一本：多个线程同时借同一本只有一个成功
+    assert(library.addBook(Book(9999, "Last Copy", "Nobody", "ISBN", "CS", 1)));
+    std::atomic<int> winners{0};
+    std::vector<std::thread> racers;
+    for (int w = 0; w < kWorkers; ++w) {
+        racers.emplace_back([&library, &winners, w] {
+            if (library.checkout("W" + std::to_string(w), 9999) == LoanResult::Ok) winners++;
+        });
+    }
+    for (auto& racer : racers) racer.join();
+    assert(winners.load() == 1);
+    assert(library.findBookById(9999)->getAvailableCopies() == 0);
+    assert(library.verifyStatistics());
+
+    {
+        // Book 的可借数无锁增减：并发借出恰好 totalCopies 次，归还同样不会超过总数
+        Book popular(1, "Popular", "Author", "ISBN", "CS", 1000);
+        std::atomic<int> borrowed{0};
+        std::atomic<int> returned{0};
+        auto hammer = [&](auto step) {
+            std::vector<std::thread> threads;
+            for (int t = 0; t < kWorkers; ++t) threads.emplace_back(step);
+            for (auto& thread : threads) thread.join();
+        };
+        hammer([&] { while (popular.borrowBook()) borrowed++; });
+        assert(borrowed.load() == 1000 && !popular.getIsAvailable());
+        hammer([&] { while (popular.returnBook()) returned++; });
+        assert(returned.load() == 1000);
+        assert(popular.getAvailableCopies() == 1000 && popular.getIsAvailable());
+        Book copy = popular;
+        assert(copy.borrowBook() && copy.getAvailableCopies() == 999 && popular.getAvailableCopies() == 1000);
+    }
+
+    std::cout << "Library stress tests passed." << std::endl;
+    return 0;
+}